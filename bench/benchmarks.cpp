@@ -0,0 +1,505 @@
+// Benchmarks of the curve kernels. Configure with
+// -DTWODCURVES_BUILD_BENCHMARKS=ON and run 2dcurves_bench, optionally with
+// a substring of the benchmark names to run.
+//
+// --save <file> writes the timings to a baseline, and --compare <file>
+// exits with an error if any timing is slower than in the baseline by
+// more than --tolerance percent, 25 by default. Baselines only compare on
+// the machine and build type they were saved with.
+
+#include "2dcurves/bezier.h"
+#include "2dcurves/chebyshev.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/intersection.h"
+#include "2dcurves/scene.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/utils.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    // Seconds per call of f, repeating it for at least min_seconds. The
+    // time is split in rounds and the fastest round is kept, since other
+    // load on the machine can only slow a round down, which keeps the
+    // baseline comparisons from failing on noise.
+    template <typename F>
+    double seconds_per_call(F&& f, double min_seconds = 0.25)
+    {
+        constexpr int rounds = 5;
+        double fastest = 0.0;
+
+        for (int round = 0; round < rounds; ++round) {
+            int calls = 0;
+            auto start = clock_type::now();
+            double elapsed = 0.0;
+
+            do {
+                f();
+                calls++;
+                elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+            } while (elapsed < min_seconds / rounds);
+
+            if (round == 0 || elapsed / calls < fastest) {
+                fastest = elapsed / calls;
+            }
+        }
+
+        return fastest;
+    }
+
+    // Timings reported so far, keyed "<benchmark>/<index>/<name>" since a
+    // benchmark reports the same names once per degree or size
+    struct Timing
+    {
+        std::string key;
+        double seconds;
+    };
+
+    std::vector<Timing> reported_timings;
+    std::string current_benchmark;
+    int report_index = 0;
+
+    void report(const char* name, double seconds, const char* unit, double items)
+    {
+        reported_timings.push_back({current_benchmark + "/" + std::to_string(report_index++) + "/" + name, seconds});
+
+        std::cout << "  " << std::left << std::setw(40) << name
+                  << std::right << std::setw(12) << std::fixed << std::setprecision(3)
+                  << seconds * 1e3 << " ms";
+        if (unit != nullptr) {
+            std::cout << std::setw(14) << std::setprecision(0) << items / seconds << " " << unit << "/s";
+        }
+        std::cout << std::endl;
+    }
+
+    // Unit-sized curves spread so that each overlaps a few others on
+    // average, like in a large drawing
+    void generate_sparse_scene(int num_curves, int num_vertices, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        float half_extent = std::sqrt((float)num_curves);
+        std::uniform_real_distribution<float> center(-half_extent, half_extent);
+        std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+
+        curves::clear_scene();
+        for (int c = 0; c < num_curves; ++c) {
+            if (c > 0) {
+                curves::start_new_curve();
+            }
+
+            glm::vec2 curve_center(center(generator), center(generator));
+            for (int i = 0; i < num_vertices; ++i) {
+                curves::add_vertex(curve_center + glm::vec2(offset(generator), offset(generator)));
+            }
+        }
+    }
+
+    void bench_intersections()
+    {
+        for (int num_curves : {1000, 10000, 100000}) {
+            generate_sparse_scene(num_curves, 4, 7);
+
+            std::vector<std::pair<int, int>> pairs;
+            double broadphase = seconds_per_call([&] {
+                pairs.clear();
+                curves::overlapping_curve_pairs(scene_curves, pairs);
+            });
+
+            // The first query also builds the subdivision hierarchies
+            std::vector<curves::Intersection> intersections;
+            auto start = clock_type::now();
+            curves::scene_intersections(intersections);
+            double cold = std::chrono::duration<double>(clock_type::now() - start).count();
+
+            double warm = seconds_per_call([&] {
+                intersections.clear();
+                curves::scene_intersections(intersections);
+            });
+
+            long long all_pairs = (long long)num_curves * (num_curves - 1) / 2;
+            std::cout << num_curves << " cubic curves, " << pairs.size() << " of "
+                      << all_pairs << " pairs overlap, " << intersections.size()
+                      << " intersections" << std::endl;
+            report("sweep and prune", broadphase, "pairs", pairs.size());
+            report("intersections (building hierarchies)", cold, "intersections", intersections.size());
+            report("intersections (cached hierarchies)", warm, "intersections", intersections.size());
+        }
+    }
+
+    void bench_bezier_operations()
+    {
+        constexpr int num_pieces = 1024;
+        std::mt19937 generator(3);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> weight(0.5f, 2.0f);
+
+        for (int degree : {2, 3, 5, 7, 15, 31}) {
+            int stride = curves::max_bezier_degree + 1;
+            std::vector<glm::vec3> pieces(num_pieces * stride);
+            for (int k = 0; k < num_pieces; ++k) {
+                for (int i = 0; i <= degree; ++i) {
+                    float w = weight(generator);
+                    pieces[k * stride + i] = glm::vec3(w * coordinate(generator), w * coordinate(generator), w);
+                }
+            }
+
+            // Results are summed so that the calls are not optimized away
+            glm::vec3 left[curves::max_bezier_degree + 1];
+            glm::vec3 right[curves::max_bezier_degree + 1];
+            volatile float sink = 0.0f;
+
+            double split = seconds_per_call([&] {
+                for (int k = 0; k < num_pieces; ++k) {
+                    curves::split_bezier(&pieces[k * stride], degree, 0.3f, left, right);
+                    sink = sink + left[degree].x;
+                }
+            });
+
+            double elevate = seconds_per_call([&] {
+                for (int k = 0; k < num_pieces; ++k) {
+                    curves::elevate_bezier(&pieces[k * stride], degree, left);
+                    sink = sink + left[1].x;
+                }
+            });
+
+            double reduce = seconds_per_call([&] {
+                for (int k = 0; k < num_pieces; ++k) {
+                    curves::reduce_bezier(&pieces[k * stride], degree, left);
+                    sink = sink + left[1].x;
+                }
+            });
+
+            std::cout << "degree " << degree << ", " << num_pieces << " pieces" << std::endl;
+            report("split", split, "pieces", num_pieces);
+            report("elevate", elevate, "pieces", num_pieces);
+            report("reduce", reduce, "pieces", num_pieces);
+        }
+    }
+
+    void bench_vertex_drag()
+    {
+        constexpr int samples = 4096;
+
+        for (int degree : {3, 7, 15, 31}) {
+            curves::generate_random_scene(1, degree + 1, 1.0f, 5);
+            Curve& curve = scene_curves[0];
+            curve.samples.resize(samples);
+            curves::evaluate_curve(curve, samples, curve.samples.data());
+            curve.dirty = false;
+
+            double full = seconds_per_call([&] {
+                curves::evaluate_curve(curve, samples, curve.samples.data());
+            });
+
+            int vertex = degree / 2;
+            double incremental = seconds_per_call([&] {
+                curve.incremental_updates = 0;
+                curves::apply_vertex_delta(curve, vertex, glm::vec2(1e-6f, 0.0f));
+            });
+
+            std::cout << "degree " << degree << ", " << samples << " samples" << std::endl;
+            report("full evaluation", full, "samples", samples);
+            report("single vertex update", incremental, "samples", samples);
+        }
+    }
+
+    // Largest distance between the points of a and b, where b is offset
+    double max_error(const std::vector<glm::vec2>& a, const std::vector<glm::vec2>& b, glm::dvec2 offset)
+    {
+        double error = 0.0;
+        for (size_t j = 0; j < a.size(); ++j) {
+            glm::dvec2 difference = glm::dvec2(a[j]) - (glm::dvec2(b[j]) + offset);
+            error = std::max(error, std::max(std::abs(difference.x), std::abs(difference.y)));
+        }
+        return error;
+    }
+
+    void bench_precision()
+    {
+        constexpr int samples = 1024;
+        const glm::vec2 far_away(1e6f, 1e6f);
+
+        for (int degree : {3, 7, 15, 31}) {
+            curves::generate_random_scene(1, degree + 1, 1.0f, 11);
+            Curve& curve = scene_curves[0];
+            for (int i = 0; i < curve.num_vertices; ++i) {
+                control_vertices[curve.first_vertex + i].position += far_away;
+            }
+            glm::vec2 origin = control_vertices[curve.first_vertex].position;
+
+            std::vector<glm::vec2> reference(samples);
+            curves::evaluate_curve_compensated(curve, origin, samples, reference.data());
+
+            std::vector<glm::vec2> out(samples);
+            double world = seconds_per_call([&] {
+                curves::evaluate_curve(curve, samples, out.data());
+            });
+            double world_error = max_error(reference, out, -glm::dvec2(origin));
+
+            double single = seconds_per_call([&] {
+                curves::evaluate_curve_relative<float>(curve, origin, samples, out.data());
+            });
+            double single_error = max_error(reference, out, glm::dvec2(0.0));
+
+            double twice = seconds_per_call([&] {
+                curves::evaluate_curve_relative<double>(curve, origin, samples, out.data());
+            });
+            double twice_error = max_error(reference, out, glm::dvec2(0.0));
+
+            double compensated = seconds_per_call([&] {
+                curves::evaluate_curve_compensated(curve, origin, samples, out.data());
+            });
+
+            std::cout << "degree " << degree << ", " << samples << " samples at 1e6 from the origin, "
+                      << "max error vs compensated: world float " << std::scientific << std::setprecision(2)
+                      << world_error << ", relative float " << single_error
+                      << ", relative double " << twice_error << std::endl;
+            report("world float", world, "samples", samples);
+            report("relative float", single, "samples", samples);
+            report("relative double", twice, "samples", samples);
+            report("compensated de Casteljau", compensated, "samples", samples);
+        }
+    }
+
+    void bench_chebyshev()
+    {
+        // bernstein_polynomial goes through binomial_coefficient, which is
+        // limited to max_bezier_degree
+        constexpr int max_bernstein_degree = curves::max_bezier_degree;
+        constexpr int accuracy_samples = 1024;
+
+        for (int degree : {7, 15, 31, 50, 100, 200, 400}) {
+            curves::generate_random_scene(1, degree + 1, 1.0f, 17);
+            const Curve& curve = scene_curves[0];
+            const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+            glm::vec2 origin = vertices[0].position;
+
+            std::vector<glm::dvec2> points(degree + 1);
+            std::vector<Vertex> relative_vertices(degree + 1);
+            for (int i = 0; i <= degree; ++i) {
+                points[i] = glm::dvec2(vertices[i].position) - glm::dvec2(origin);
+                relative_vertices[i].position = glm::vec2(points[i]);
+            }
+
+            std::vector<glm::dvec2> coefficients(degree + 1);
+            double conversion = seconds_per_call([&] {
+                curves::bernstein_to_chebyshev(points.data(), degree, coefficients.data());
+            });
+
+            std::vector<glm::dvec2> round_trip(degree + 1);
+            curves::chebyshev_to_bernstein(coefficients.data(), degree, round_trip.data());
+            double round_trip_error = 0.0;
+            for (int i = 0; i <= degree; ++i) {
+                glm::dvec2 difference = round_trip[i] - points[i];
+                round_trip_error = std::max(round_trip_error, std::max(std::abs(difference.x), std::abs(difference.y)));
+            }
+
+            // Errors at uniform parameters against compensated de Casteljau,
+            // and of the cosine transform against Clenshaw at the nodes
+            std::vector<glm::vec2> reference(accuracy_samples);
+            std::vector<glm::vec2> out(accuracy_samples);
+            curves::evaluate_curve_compensated(curve, origin, accuracy_samples, reference.data());
+
+            curves::evaluate_chebyshev_curve(coefficients.data(), degree, accuracy_samples, out.data());
+            double clenshaw_error = max_error(reference, out, glm::dvec2(0.0));
+
+            double table_error = -1.0;
+            if (degree <= max_bernstein_degree) {
+                curves::evaluate_bezier_curve(relative_vertices.data(), degree + 1, accuracy_samples, out.data());
+                table_error = max_error(reference, out, glm::dvec2(0.0));
+            }
+
+            curves::evaluate_chebyshev_nodes(coefficients.data(), degree, accuracy_samples, out.data());
+            for (int j = 0; j < accuracy_samples; ++j) {
+                double t = curves::chebyshev_node(j, accuracy_samples);
+                reference[j] = glm::vec2(curves::evaluate_chebyshev(coefficients.data(), degree, t));
+            }
+            double nodes_error = max_error(reference, out, glm::dvec2(0.0));
+
+            std::cout << "degree " << degree << ", max error vs compensated: " << std::scientific << std::setprecision(2);
+            if (table_error >= 0.0) {
+                std::cout << "Bernstein table " << table_error << ", ";
+            }
+            std::cout << "Clenshaw " << clenshaw_error << ", cosine transform vs Clenshaw " << nodes_error
+                      << ", Bernstein round trip " << round_trip_error << std::endl;
+            report("conversion to Chebyshev", conversion, nullptr, 0);
+
+            for (int samples : {1024, 16384}) {
+                out.resize(samples);
+                std::vector<std::pair<const char*, double>> timings;
+
+                if (degree <= max_bernstein_degree) {
+                    std::vector<float> t_values = curves::linspace(0.0f, 1.0f, samples);
+                    timings.emplace_back("bernstein_polynomial sums", seconds_per_call([&] {
+                        for (int j = 0; j < samples; ++j) {
+                            glm::vec2 point(0.0f);
+                            for (int i = 0; i <= degree; ++i) {
+                                point += curves::bernstein_polynomial(degree, i, t_values[j]) * relative_vertices[i].position;
+                            }
+                            out[j] = point;
+                        }
+                    }));
+
+                    // The first call builds the table, it is cached after
+                    curves::evaluate_bezier_curve(relative_vertices.data(), degree + 1, samples, out.data());
+                    timings.emplace_back("Bernstein table (cached)", seconds_per_call([&] {
+                        curves::evaluate_bezier_curve(relative_vertices.data(), degree + 1, samples, out.data());
+                    }));
+                }
+
+                timings.emplace_back("Clenshaw, uniform parameters", seconds_per_call([&] {
+                    curves::evaluate_chebyshev_curve(coefficients.data(), degree, samples, out.data());
+                }));
+
+                timings.emplace_back("cosine transform, Chebyshev nodes", seconds_per_call([&] {
+                    curves::evaluate_chebyshev_nodes(coefficients.data(), degree, samples, out.data());
+                }));
+
+                std::cout << " " << samples << " samples" << std::endl;
+                for (const auto& [name, seconds] : timings) {
+                    report(name, seconds, "samples", samples);
+                }
+
+                auto fastest = std::min_element(timings.begin(), timings.end(), [](const auto& a, const auto& b) {
+                    return a.second < b.second;
+                });
+                std::cout << "  fastest: " << fastest->first << std::endl;
+            }
+        }
+    }
+
+    bool read_baseline(const char* path, std::map<std::string, double>& baseline)
+    {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "ERROR::BENCH::could not read " << path << std::endl;
+            return false;
+        }
+
+        double seconds;
+        std::string key;
+        while (in >> seconds >> std::ws && std::getline(in, key)) {
+            baseline[key] = seconds;
+        }
+        return true;
+    }
+
+    // Lists the timings slower than the baseline by more than tolerance
+    // percent, true if there are none. Timings missing from either side
+    // are skipped, so a filtered run compares only what it ran.
+    bool compare_with_baseline(const std::map<std::string, double>& baseline, double tolerance)
+    {
+        int compared = 0;
+        int regressions = 0;
+
+        std::cout << "\n[baseline]" << std::endl;
+        for (const Timing& timing : reported_timings) {
+            auto it = baseline.find(timing.key);
+            if (it == baseline.end()) {
+                continue;
+            }
+
+            compared++;
+            double change = 100.0 * (timing.seconds / it->second - 1.0);
+            if (change > tolerance) {
+                regressions++;
+                std::cout << "  REGRESSION " << timing.key << ": " << std::fixed << std::setprecision(3)
+                          << timing.seconds * 1e3 << " ms, was " << it->second * 1e3 << " ms ("
+                          << std::setprecision(0) << "+" << change << "%)" << std::endl;
+            }
+        }
+
+        std::cout << "  " << compared << " timings compared, " << regressions << " slower by more than "
+                  << std::fixed << std::setprecision(0) << tolerance << "%" << std::endl;
+        return regressions == 0;
+    }
+
+    struct Benchmark
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Benchmark benchmarks[] = {
+        {"bezier operations", bench_bezier_operations},
+        {"chebyshev", bench_chebyshev},
+        {"intersections", bench_intersections},
+        {"precision", bench_precision},
+        {"vertex drag", bench_vertex_drag},
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = "";
+    const char* save_path = nullptr;
+    const char* compare_path = nullptr;
+    double tolerance = 25.0;
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--save") == 0 && has_value) {
+            save_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && has_value) {
+            compare_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    // Read first so that a missing baseline fails before the long run
+    std::map<std::string, double> baseline;
+    if (compare_path != nullptr && !read_baseline(compare_path, baseline)) {
+        return 1;
+    }
+
+    for (const Benchmark& benchmark : benchmarks) {
+        if (std::strstr(benchmark.name, filter) == nullptr) {
+            continue;
+        }
+
+        std::cout << "\n[" << benchmark.name << "]" << std::endl;
+        current_benchmark = benchmark.name;
+        report_index = 0;
+        benchmark.run();
+    }
+
+    if (save_path != nullptr) {
+        std::ofstream out(save_path);
+        out << std::scientific << std::setprecision(6);
+        for (const Timing& timing : reported_timings) {
+            out << timing.seconds << " " << timing.key << "\n";
+        }
+        if (!out) {
+            std::cerr << "ERROR::BENCH::could not write " << save_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (compare_path != nullptr && !compare_with_baseline(baseline, tolerance)) {
+        return 1;
+    }
+
+    return 0;
+}
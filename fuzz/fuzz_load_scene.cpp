@@ -0,0 +1,48 @@
+// libFuzzer target for the text scene loader. Configure with
+// -DTWODCURVES_BUILD_FUZZERS=ON using clang, then run fuzz_load_scene with
+// a corpus directory, e.g. one holding scene files saved by 2dcurves.
+
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/polyline_export.h"
+#include "2dcurves/scene_file.h"
+
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    std::istringstream in(std::string(reinterpret_cast<const char*>(data), size));
+    if (!curves::load_scene(in)) {
+        return 0;
+    }
+
+    // Every loaded curve must split into Bézier pieces that fit the arrays
+    // of bezier.h, which flatten_curve starts with. The tolerance scales
+    // with the curve to keep the subdivision short.
+    std::vector<glm::vec2> polyline;
+    for (const Curve& curve : scene_curves) {
+        glm::vec2 extent = curve.bounds.max - curve.bounds.min;
+        float tolerance = 1e-2f * std::max(extent.x, extent.y);
+        if (!(tolerance > 0.0f)) {
+            tolerance = 1.0f;
+        }
+
+        polyline.clear();
+        curves::flatten_curve(curve, control_vertices.data() + curve.first_vertex, tolerance, polyline);
+    }
+
+    // A loaded scene must write back to a file that loads again
+    std::stringstream out;
+    curves::write_scene(out);
+    if (!curves::load_scene(out)) {
+        __builtin_trap();
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+
+#include <limits>
+
+// Axis-aligned bounding box, empty while min > max
+struct AABB
+{
+    glm::vec2 min = glm::vec2(std::numeric_limits<float>::infinity());
+    glm::vec2 max = glm::vec2(-std::numeric_limits<float>::infinity());
+
+    bool empty() const
+    {
+        return min.x > max.x || min.y > max.y;
+    }
+
+    void expand(glm::vec2 point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void expand(const AABB& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool overlaps(const AABB& other) const
+    {
+        return min.x <= other.max.x && other.min.x <= max.x &&
+               min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    // Points on the boundary are the only ones whose removal can shrink the box
+    bool on_boundary(glm::vec2 point) const
+    {
+        return point.x == min.x || point.x == max.x ||
+               point.y == min.y || point.y == max.y;
+    }
+
+    glm::vec2 center() const
+    {
+        return 0.5f * (min + max);
+    }
+
+    glm::vec2 size() const
+    {
+        return max - min;
+    }
+};
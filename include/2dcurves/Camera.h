@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+// 2d view of the world, at zoom 1 the window spans [-1, 1] around center.
+// The center is kept in double so that panning far from the origin does
+// not snap the view to the float grid.
+struct Camera
+{
+    glm::dvec2 center = glm::dvec2(0.0, 0.0);
+    float zoom = 1.0f;
+};
+
+namespace curves{
+
+    // Maps camera-relative positions, see camera_relative, to clip space.
+    // The translation is left to the CPU, which does it in double.
+    glm::mat4 view_projection(const Camera& camera);
+
+    // world - camera.center, rounded to float only after the subtraction
+    glm::vec2 camera_relative(const Camera& camera, glm::vec2 world);
+
+    glm::vec2 ndc_to_world(const Camera& camera, glm::vec2 position_NDC);
+
+    // Scales the zoom by factor while keeping the world point under
+    // anchor_NDC in place
+    void zoom_camera(Camera& camera, glm::vec2 anchor_NDC, float factor);
+
+    void pan_camera(Camera& camera, glm::vec2 delta_NDC);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "2dcurves/AABB.h"
+#include "2dcurves/CurveHierarchy.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// Flags stored in the per-curve shader records
+enum curve_flags : unsigned int
+{
+    curve_flag_selected = 1u << 0,
+    curve_flag_hovered = 1u << 1
+};
+
+// Densities at which a curve's tessellation is cached, see tessellation.h
+constexpr int num_lod_levels = 6;
+
+// A curve made of a contiguous range of control_vertices. It is a
+// (rational) Bézier curve while knots is empty and a NURBS curve of degree
+// knots.size() - num_vertices - 1 with a clamped knot vector otherwise.
+struct Curve
+{
+    int first_vertex = 0;
+    int num_vertices = 0;
+    std::vector<float> knots;
+
+    glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    float width = 1.0f;
+    unsigned int flags = 0;
+
+    // Bounds of the control polygon, which contain the curve
+    AABB bounds;
+
+    // Incremented on every edit, caches derived from the curve remember
+    // the revision they were built for
+    unsigned int revision = 0;
+
+    // Tessellation at the LOD level in use, re-evaluated when the curve is
+    // edited. Samples [upload_begin, upload_end) changed since the last
+    // upload.
+    bool dirty = true;
+    bool needs_upload = true;
+    int upload_begin = 0;
+    int upload_end = 0;
+    std::vector<glm::vec2> samples;
+    int sample_offset = 0;
+    int lod_level = -1;
+
+    // Samples as last handed to the render thread, shared with the frame
+    // snapshots still holding them. Replaced rather than modified when
+    // needs_upload says the samples changed.
+    std::shared_ptr<const std::vector<glm::vec2>> published_samples;
+
+    // Samples are stored relative to this point, the first vertex when
+    // the curve was last edited, which keeps them precise far from the
+    // world origin
+    glm::vec2 sample_origin = glm::vec2(0.0f, 0.0f);
+
+    // Levels evaluated earlier and not in use, so that zooming back and
+    // forth does not re-evaluate. Bit k of lod_cache_valid tells whether
+    // lod_cache[k] still matches the curve.
+    std::array<std::vector<glm::vec2>, num_lod_levels> lod_cache;
+    unsigned int lod_cache_valid = 0;
+
+    // Vertex moves applied to the samples in place since they were last
+    // evaluated, bounded to keep rounding errors from accumulating
+    int incremental_updates = 0;
+
+    // Cumulative arc length at uniformly spaced parameters
+    std::vector<float> arc_lengths;
+    unsigned int arc_lengths_revision = ~0u;
+
+    // Subdivision hierarchy for distance queries
+    CurveHierarchy hierarchy;
+};
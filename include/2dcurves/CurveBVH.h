@@ -0,0 +1,43 @@
+#pragma once
+
+#include "2dcurves/AABB.h"
+#include "2dcurves/Curve.h"
+
+#include <vector>
+
+// Bounding volume hierarchy over the bounding boxes of a list of curves.
+// Editing a curve only needs a refit of its path to the root, adding or
+// removing curves needs a rebuild.
+class CurveBVH
+{
+public:
+    void build(const std::vector<Curve>& curves);
+
+    // Propagates a change of the bounds of one curve up the tree
+    void refit(const std::vector<Curve>& curves, int curve_index);
+
+    // Appends the indices of the curves whose bounds overlap view
+    void query(const std::vector<Curve>& curves, const AABB& view, std::vector<int>& out) const;
+
+    int size() const { return leaf_of_curve.size(); }
+
+private:
+    struct Node
+    {
+        AABB bounds;
+        int parent = -1;
+        // Inner nodes have two children, leaves a range of curve_indices
+        int left = -1;
+        int right = -1;
+        int first = 0;
+        int count = 0;
+    };
+
+    static constexpr int max_leaf_size = 4;
+
+    std::vector<Node> nodes;
+    std::vector<int> curve_indices;
+    std::vector<int> leaf_of_curve;
+
+    int buildNode(const std::vector<Curve>& curves, int parent, int first, int count);
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "2dcurves/AABB.h"
+
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// Recursive subdivision of a curve into Bézier pieces, each bounded by the
+// box of its control polygon. Leaves are nearly flat pieces.
+struct CurveHierarchy
+{
+    struct Node
+    {
+        AABB bounds;
+        float t0;
+        float t1;
+        int left = -1;
+        int right = -1;
+        // degree + 1 homogeneous control points in points
+        int first_point;
+    };
+
+    int degree = 0;
+    std::vector<Node> nodes;
+    std::vector<int> roots;
+    std::vector<glm::vec3> points;
+
+    unsigned int revision = ~0u;
+};
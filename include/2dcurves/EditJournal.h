@@ -0,0 +1,134 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// Kinds of scene mutations, each stored with the payload noted
+enum class edit_type : std::uint8_t
+{
+    add_vertex,        // VertexEdit, the added vertex in after
+    remove_vertex,     // VertexEdit, the removed vertex in before
+    move_vertex,       // VertexEdit
+    set_weight,        // VertexEdit
+    set_knots,         // ListEdit followed by the old then the new knots
+    replace_vertices,  // ListEdit followed by the old then the new (x, y, weight)
+    new_curve,         // CurveEdit
+    swap_scene         // SceneEdit
+};
+
+struct VertexEdit
+{
+    std::int32_t curve;
+    std::int32_t vertex;
+    glm::vec2 before_position;
+    float before_weight;
+    glm::vec2 after_position;
+    float after_weight;
+};
+
+// Header of the variable size payloads
+struct ListEdit
+{
+    std::int32_t curve;
+    std::int32_t num_before;
+    std::int32_t num_after;
+};
+
+struct CurveEdit
+{
+    glm::vec4 color;
+    float width;
+};
+
+// Whole scenes are kept aside by their owner rather than copied into the
+// journal, stash identifies one
+struct SceneEdit
+{
+    std::uint32_t stash;
+};
+
+struct EditRecord
+{
+    edit_type type;
+    const unsigned char* payload;
+    std::size_t size;
+};
+
+// Undo history of scene mutations, kept as compact deltas in a fixed
+// size ring of bytes. When full, the oldest steps are dropped. Undo and
+// redo cost as much as the step they apply, whatever the size of the scene.
+class EditJournal
+{
+public:
+    // arena_capacity bounds the bytes of payload, external_capacity those
+    // that records keep alive outside of the journal, like a stashed scene.
+    // discard is called on every record that leaves the journal without
+    // being undone or redone.
+    EditJournal(std::size_t arena_capacity, std::size_t external_capacity, void (*discard)(const EditRecord&));
+
+    // Records appended between beginStep and endStep, which nest, are
+    // undone as one step. Any other record is a step of its own.
+    void beginStep();
+    void endStep();
+
+    // Appends a record and forgets the steps that were undone.
+    // external_size counts against external_capacity. Returns false, after
+    // discarding the record, if it cannot fit.
+    bool append(edit_type type, const void* payload, std::size_t size, std::size_t external_size = 0);
+
+    // Updates the latest add or move of the same vertex instead of
+    // appending, if that is part of the open step or the newest add
+    void appendMove(const VertexEdit& edit);
+
+    // Records of the step to undo, newest first, or of the step to redo,
+    // oldest first. Payloads stay valid until the next append.
+    bool undo(std::vector<EditRecord>& records);
+    bool redo(std::vector<EditRecord>& records);
+
+    void clear();
+
+    std::size_t arenaBytes() const { return arena_bytes; }
+
+private:
+    struct Entry
+    {
+        std::uint32_t offset;
+        std::uint32_t size;
+        std::size_t external_size;
+        edit_type type;
+        // Part of the same step as the previous entry
+        bool continues;
+    };
+
+    std::vector<unsigned char> arena;
+    std::size_t arena_capacity;
+    std::size_t external_capacity;
+    void (*discard)(const EditRecord&);
+
+    // Oldest first, the first num_applied are done and the others undone
+    std::deque<Entry> entries;
+    std::size_t num_applied = 0;
+    std::size_t arena_bytes = 0;
+    std::size_t external_bytes = 0;
+
+    int step_depth = 0;
+    // Index of the first entry of the open step, -1 before its first append
+    long long step_first = -1;
+    // The open step did not fit, its remaining records are dropped
+    bool step_overflowed = false;
+
+    // Entry indices of the records appendMove may update, per vertex
+    std::unordered_map<std::int32_t, std::size_t> mergeable_moves;
+
+    EditRecord record(const Entry& entry) const;
+    // Drops the oldest step
+    void dropFront();
+    // Drops the newest record
+    void dropBack();
+};
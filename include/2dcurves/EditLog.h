@@ -0,0 +1,68 @@
+#pragma once
+
+#include "2dcurves/EditJournal.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Crash-safe persistence of the scene. Every mutation is appended to a
+// binary log of journal records, and the log is compacted into a binary
+// scene snapshot once it outgrows it. Recovery loads the snapshot and
+// replays the records logged since, in time proportional to the log.
+//
+// Records reach the OS at every flush, which survives the process dying,
+// and the disk at most sync_interval later, which survives power loss.
+// Snapshots replace the previous one atomically. Both files carry a
+// generation so that a log is never replayed on top of a newer snapshot.
+class EditLog
+{
+public:
+    EditLog(std::string snapshot_path, std::string log_path);
+    ~EditLog();
+
+    // Replaces the scene with the snapshot and the log written after it,
+    // then appends to that log. Returns false, leaving the scene alone, if
+    // there is no valid snapshot.
+    bool recover();
+
+    // Buffers one record seen by the scene's edit observer
+    void append(const EditRecord& record, bool forward);
+
+    // Writes the current scene as the new snapshot and starts an empty log
+    void snapshot();
+
+    // Writes the buffered records, syncs them to disk if the last sync is
+    // older than sync_interval, and compacts the log when it grew too
+    // large. Meant to be called once per frame. If the log could not be
+    // opened the buffered records are dropped.
+    void flush();
+
+    // Records replayed by the last recover()
+    int replayedCount() const { return num_replayed; }
+
+private:
+    static constexpr double sync_interval = 0.5;
+
+    // Compaction happens when the log exceeds the snapshot's size, and at
+    // least this many bytes
+    static constexpr std::uint64_t min_compaction_bytes = std::uint64_t(1) << 20;
+
+    std::string snapshot_path;
+    std::string log_path;
+    std::FILE* log = nullptr;
+    std::uint64_t generation = 0;
+
+    std::vector<unsigned char> buffer;
+    std::uint64_t log_bytes = 0;
+    std::uint64_t snapshot_bytes = 0;
+    int num_replayed = 0;
+
+    bool unsynced = false;
+    std::chrono::steady_clock::time_point last_sync;
+
+    void startLog();
+    void closeLog();
+};
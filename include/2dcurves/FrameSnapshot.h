@@ -0,0 +1,73 @@
+#pragma once
+
+#include "2dcurves/Camera.h"
+#include "2dcurves/shader_data.h"
+#include "2dcurves/VertexSelection.h"
+
+#include <glm/vec2.hpp>
+
+#include <memory>
+#include <vector>
+
+enum class line_style {strip, batched_strip, wide};
+
+// Everything a frame draws, copied out of the scene by the thread that
+// edits it for the render thread, which never reads the scene. Immutable
+// once published. The samples of a curve are shared with earlier
+// snapshots until the curve changes, so a snapshot copies the records and
+// control points of the scene but only the samples that moved.
+struct FrameSnapshot
+{
+    // Consecutive vertices of a curve, drawn with the curve's record
+    struct VertexRange
+    {
+        int curve;
+        int first;
+        int count;
+    };
+
+    curves::FrameData frame;
+    line_style lines = line_style::strip;
+    bool report_frame_times = false;
+    bool show_stats = false;
+
+    // CPU time the scene thread spent on the update that made this snapshot
+    double update_milliseconds = 0.0;
+
+    // One per curve of the scene, the draw ids index them
+    std::vector<curves::CurveRecord> records;
+
+    // Samples of the visible curves relative to their sample origin, laid
+    // out back to back in this order in the sample buffer
+    std::vector<int> visible_curves;
+    std::vector<std::shared_ptr<const std::vector<glm::vec2>>> samples;
+
+    // Control vertices relative to the sample origin of their curve,
+    // indexed like control_vertices. Empty when the control polygons are
+    // hidden.
+    std::vector<glm::vec2> control_points;
+    std::vector<VertexRange> control_polygons;
+    std::vector<VertexRange> selected_vertices;
+
+    // Closed outline of the selection gesture, relative to the camera
+    std::vector<glm::vec2> outline;
+
+    // Oldest input, and cursor read that moved vertices, first shown by
+    // this snapshot, from glfwGetTime(). Negative if none.
+    double input_time = -1.0;
+    double cursor_time = -1.0;
+};
+
+namespace curves{
+
+    // Snapshot of the visible curves as seen by camera, after
+    // update_tessellations. The samples of the curves that need an upload
+    // are republished, the others shared. Control polygons and selected
+    // vertices are only included if show_control_polygons.
+    std::shared_ptr<FrameSnapshot> make_frame_snapshot(
+        const Camera& camera,
+        const std::vector<int>& visible_curves,
+        bool show_control_polygons,
+        const VertexSelection& selection
+    );
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "2dcurves/Shader.h"
+#include "2dcurves/shader_data.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Tessellates the visible curves with a compute shader. Control points are
+// kept in a pool on the GPU that mirrors control_vertices, and the shader
+// writes the samples straight into the buffer the draws read, nothing is
+// read back. Only curves that were edited, changed LOD or came into view
+// are evaluated; when the layout of the sample buffer changes, the others
+// are copied over on the GPU.
+//
+// NURBS curves are evaluated on the CPU and uploaded. Samples are always
+// uniformly spaced and in float, whatever arc_length_sampling and
+// sample_precision say.
+class GpuTessellator
+{
+public:
+    explicit GpuTessellator(const char* computePath);
+    ~GpuTessellator();
+
+    // Counterpart of upload_bezier_curves, lays out the visible curves in
+    // sample_vbo like it and evaluates those that need it
+    void update(unsigned int sample_vbo, const std::vector<int>& visible_curves);
+
+    // Forgets the contents of the sample buffer, after something else
+    // wrote to it
+    void invalidate();
+
+    // Curves evaluated by the last update
+    int evaluatedCount() const { return num_evaluated; }
+
+private:
+    // Upper bound of the work groups of a dispatch, each loops over jobs
+    static constexpr unsigned int max_work_groups = 65535;
+
+    Shader program;
+    int num_jobs_location;
+
+    unsigned int point_pool = 0;
+    std::size_t point_pool_bytes = 0;
+    unsigned int job_buffer = 0;
+    std::size_t job_buffer_bytes = 0;
+    unsigned int previous_samples = 0;
+    std::size_t previous_samples_bytes = 0;
+
+    // Curves laid out in the sample buffer by the last update, and whether
+    // each curve index is one of them
+    std::vector<int> resident_curves;
+    std::vector<bool> resident;
+    int num_resident_samples = 0;
+
+    std::vector<int> levels;
+    std::vector<curves::TessellationJob> jobs;
+    std::vector<int> evaluated_curves;
+    std::vector<glm::vec4> staged_points;
+    std::vector<glm::vec2> staged_samples;
+    int num_evaluated = 0;
+
+    // Writes the control points of the curves in evaluated_curves to the
+    // pool, relative to their sample origin
+    void uploadControlPoints();
+};
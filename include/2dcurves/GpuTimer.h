@@ -0,0 +1,34 @@
+#pragma once
+
+// Measures the GPU time spent between begin() and end() with timer queries.
+// Results are collected a few frames later, so the CPU never waits for them.
+class GpuTimer
+{
+public:
+    GpuTimer();
+
+    void begin();
+    void end();
+
+    // Average over the intervals completed since the last call, in
+    // milliseconds. Returns a negative value if none completed.
+    double takeAverageMilliseconds();
+
+    // Latest completed interval, in milliseconds, without taking it.
+    // Negative until one completed.
+    double lastMilliseconds() const { return last_milliseconds; }
+
+private:
+    static constexpr int num_queries = 4;
+
+    unsigned int queries[num_queries];
+    int first_pending = 0;
+    int num_pending = 0;
+    bool measuring = false;
+
+    double total_milliseconds = 0.0;
+    double last_milliseconds = -1.0;
+    int num_results = 0;
+
+    void collect();
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+// Measures the latency from input to the presentation of the frame that
+// shows it. A timestamp query issued after the buffer swap tells when the
+// GPU finished the frame, which is read a few frames later like GpuTimer
+// so the CPU never waits. Scan-out to the display is not included.
+class LatencyTracker
+{
+public:
+    LatencyTracker();
+
+    // Time of an input, from glfwGetTime(). The next presented frame is
+    // attributed to the oldest input since the previous one.
+    void inputArrived(double time);
+
+    // Call right after glfwSwapBuffers
+    void framePresented();
+
+    // Average and maximum latency of the frames completed since the last
+    // call, in milliseconds. Returns false if none completed.
+    bool takeMilliseconds(double& average, double& maximum);
+
+private:
+    static constexpr int num_queries = 4;
+
+    unsigned int queries[num_queries];
+    double input_times[num_queries];
+    int first_pending = 0;
+    int num_pending = 0;
+
+    // Oldest input not yet attributed to a frame, negative if none
+    double pending_input_time = -1.0;
+
+    // glfwGetTime() minus the GPU clock, in seconds
+    double clock_offset = 0.0;
+
+    double total_milliseconds = 0.0;
+    double max_milliseconds = 0.0;
+    int num_results = 0;
+
+    void calibrate();
+    void collect();
+};
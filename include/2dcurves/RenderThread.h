@@ -0,0 +1,89 @@
+#pragma once
+
+#include "2dcurves/FrameSnapshot.h"
+#include "2dcurves/GpuTimer.h"
+#include "2dcurves/LatencyTracker.h"
+#include "2dcurves/Shader.h"
+#include "2dcurves/SnapshotMailbox.h"
+#include "2dcurves/StatsHud.h"
+#include "2dcurves/StripBatch.h"
+
+#include <GLFW/glfw3.h>
+#include <glm/vec2.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Draws frame snapshots on a thread of its own, which holds the GL context
+// of the window while it runs. It sleeps until a snapshot is published,
+// takes the latest one without locking, draws it and swaps, so a slow
+// swap never holds up the thread handling input, and a slow scene update
+// only delays the next snapshot.
+//
+// Samples stay in a buffer of the render thread between frames, only the
+// arrays that differ from the previous snapshot are uploaded.
+class RenderThread
+{
+public:
+    // The programs and the frame, curve and draw id buffers are shared
+    // with the main thread, only one thread uses the context at a time
+    RenderThread(
+        Shader& curve_program,
+        Shader& wide_line_program,
+        unsigned int frame_ubo,
+        unsigned int curve_ssbo,
+        unsigned int draw_id_vbo
+    );
+    ~RenderThread();
+
+    // Starts drawing into window on a new thread. The calling thread must
+    // have released the context.
+    void start(GLFWwindow* window);
+
+    // Finishes the frame in progress and ends the thread, which releases
+    // the context
+    void stop();
+
+    bool running() const { return thread.joinable(); }
+
+    // Hands a snapshot to the render thread. Returns the one it replaced if
+    // that was never drawn.
+    std::shared_ptr<const FrameSnapshot> publish(std::shared_ptr<const FrameSnapshot> snapshot);
+
+private:
+    Shader& curve_program;
+    Shader& wide_line_program;
+    int highlight_mode_location;
+
+    unsigned int frame_ubo;
+    unsigned int curve_ssbo;
+    unsigned int draw_id_vbo;
+
+    unsigned int sample_vbo = 0;
+    unsigned int control_point_vbo = 0;
+    unsigned int sample_vao = 0;
+    unsigned int control_point_vao = 0;
+    unsigned int wide_line_vao = 0;
+    StripBatch strip_batch;
+    StatsHud stats_hud;
+
+    GpuTimer curve_pass_timer;
+    LatencyTracker input_latency;
+    LatencyTracker cursor_latency;
+    double last_report_time = 0.0;
+
+    GLFWwindow* window = nullptr;
+    std::thread thread;
+    SnapshotMailbox mailbox;
+
+    // Last snapshot drawn, whose samples are in sample_vbo
+    std::shared_ptr<const FrameSnapshot> drawn;
+    std::vector<int> sample_counts;
+    std::vector<glm::vec2> staged_samples;
+
+    void run();
+    void draw(const FrameSnapshot& snapshot);
+    void uploadSamples(const FrameSnapshot& snapshot);
+    void report(const FrameSnapshot& snapshot);
+};
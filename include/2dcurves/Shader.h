@@ -1,6 +1,12 @@
 #pragma once
 
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
 #include <string>
+#include <unordered_map>
 
 class Shader
 {
@@ -9,8 +15,25 @@ public:
 
     Shader(const char* vertexPath, const char* fragmentPath);
 
+    // Compute program
+    explicit Shader(const char* computePath);
+
     void use();
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
+
+    // Location of an active uniform, resolved once after linking.
+    // Returns -1 for names that are not active in the program.
+    int getUniformLocation(const std::string &name) const;
+
+    void setBool(int location, bool value) const;
+    void setInt(int location, int value) const;
+    void setFloat(int location, float value) const;
+    void setVec2(int location, const glm::vec2 &value) const;
+    void setVec4(int location, const glm::vec4 &value) const;
+    void setMat3(int location, const glm::mat3 &value) const;
+    void setMat4(int location, const glm::mat4 &value) const;
+
+private:
+    std::unordered_map<std::string, int> uniformLocations;
+
+    void cacheUniformLocations();
 };
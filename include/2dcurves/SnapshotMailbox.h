@@ -0,0 +1,49 @@
+#pragma once
+
+#include "2dcurves/FrameSnapshot.h"
+
+#include <atomic>
+#include <memory>
+
+// Hands the latest frame snapshot from the scene thread to the render
+// thread. A triple buffer: the writer fills one slot, the reader draws
+// from another, and the third holds the latest published snapshot, traded
+// for either of the others with one atomic exchange. Neither side waits
+// for the other; a snapshot published before the previous one was taken
+// replaces it.
+class SnapshotMailbox
+{
+public:
+    // Writer side. Returns the snapshot this one replaced if the reader
+    // never took it, null otherwise.
+    std::shared_ptr<const FrameSnapshot> publish(std::shared_ptr<const FrameSnapshot> snapshot);
+
+    // Reader side. Latest snapshot published since the last take, null if
+    // there is none.
+    std::shared_ptr<const FrameSnapshot> take();
+
+    // Reader side. Sleeps until there is a snapshot to take or the mailbox
+    // is closed, returns false in the latter case.
+    bool wait();
+
+    // Wakes the reader for good
+    void close();
+
+    // Empties the slots and reopens the mailbox, while neither side uses it
+    void reset();
+
+private:
+    static constexpr unsigned int index_mask = 3;
+    static constexpr unsigned int fresh_bit = 4;
+    static constexpr unsigned int wake_bit = 8;
+
+    std::shared_ptr<const FrameSnapshot> slots[3];
+
+    // Index of the latest slot, with fresh_bit until the reader takes it
+    std::atomic<unsigned int> latest{1};
+    std::atomic<bool> closed{false};
+
+    // Owned by the writer and the reader
+    unsigned int back = 0;
+    unsigned int front = 2;
+};
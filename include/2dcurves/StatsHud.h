@@ -0,0 +1,66 @@
+#pragma once
+
+#include "2dcurves/Shader.h"
+
+#include <glm/vec2.hpp>
+
+#include <array>
+#include <vector>
+
+// Statistics drawn over the scene with the curve program, without fonts.
+// Each statistic gets a row with a bar graph of its recent history, scaled
+// to the largest value in it, and its latest value in seven-segment
+// digits. The history is a fixed ring buffer, and the geometry, a few
+// thousand vertices drawn in six draws, is rewritten every frame into a
+// buffer allocated once.
+class StatsHud
+{
+public:
+    // Statistics of one frame, shown from the top in this order
+    struct Sample
+    {
+        int curves;
+        int samples;
+        double upload_bytes;
+        double cpu_milliseconds;
+        // Negative while no measurement is available, the previous value
+        // is shown
+        double gpu_milliseconds;
+    };
+
+    explicit StatsHud(Shader& program);
+    ~StatsHud();
+
+    void record(const Sample& sample);
+
+    // Draws the history in the bottom left corner of the window, leaves
+    // the program in use with highlight mode 0
+    void draw();
+
+private:
+    static constexpr int history_size = 120;
+    static constexpr int num_statistics = 5;
+
+    // Characters of a value, longer ones are cut
+    static constexpr int max_characters = 12;
+
+    static constexpr int max_vertices =
+        6 + num_statistics * 6 * (history_size + 7 * max_characters);
+
+    Shader& program;
+    int highlight_mode_location;
+    int hud_color_location;
+
+    unsigned int vao = 0;
+    unsigned int vbo = 0;
+
+    // history[(first + k) % history_size] is the k-th oldest sample
+    std::array<std::array<float, num_statistics>, history_size> history;
+    int first = 0;
+    int count = 0;
+
+    std::vector<glm::vec2> vertices;
+    std::array<int, num_statistics + 1> row_starts;
+
+    void addRow(int row);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+// Draws the line strips of all visible curves with one glDrawElements.
+// The samples stay where the tessellation put them, an index buffer walks
+// through them with a primitive restart index between curves, and a
+// per-vertex curve id replaces the base instance of the per-curve draws.
+//
+// Both buffers only depend on which curves are visible and how many
+// samples each has, so they are only rewritten when that changes, not
+// when the samples move.
+class StripBatch
+{
+public:
+    StripBatch();
+    ~StripBatch();
+
+    // Call after the tessellation update, with the buffer it wrote
+    void update(unsigned int sample_vbo, const std::vector<int>& visible_curves);
+
+    // Same for samples laid out back to back in the order of
+    // visible_curves, sample_counts[k] of them for visible_curves[k]
+    void update(unsigned int sample_vbo, const std::vector<int>& visible_curves, const std::vector<int>& sample_counts);
+
+    void draw() const;
+
+    // Times the index buffer was rewritten
+    int rebuildCount() const { return num_rebuilds; }
+
+private:
+    static constexpr unsigned int restart_index = 0xFFFFFFFFu;
+
+    unsigned int vao = 0;
+    unsigned int index_buffer = 0;
+    unsigned int curve_id_buffer = 0;
+    unsigned int bound_sample_vbo = 0;
+
+    // Topology the buffers were built for
+    std::vector<int> batched_curves;
+    std::vector<int> batched_samples;
+    std::vector<int> resident_counts;
+    int num_indices = 0;
+    int num_rebuilds = 0;
+
+    void rebuild(const std::vector<int>& visible_curves, const std::vector<int>& sample_counts);
+};
@@ -5,5 +5,5 @@
 struct Vertex
 {
     glm::vec2 position;
-    bool is_moving = false;
+    float weight = 1.0f;
 };
\ No newline at end of file
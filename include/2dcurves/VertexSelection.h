@@ -0,0 +1,67 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Set of indices into control_vertices, one bit per vertex. Iteration
+// skips unselected words, so it costs the size of the scene / 64 plus the
+// number of selected vertices.
+class VertexSelection
+{
+public:
+    // Makes room for num_vertices, dropping the indices beyond
+    void resize(int num_vertices);
+
+    void clear();
+
+    void insert(int vertex) { words[vertex >> 6] |= std::uint64_t(1) << (vertex & 63); }
+    void erase(int vertex) { words[vertex >> 6] &= ~(std::uint64_t(1) << (vertex & 63)); }
+
+    bool contains(int vertex) const
+    {
+        return vertex < num_vertices && (words[vertex >> 6] >> (vertex & 63) & 1) != 0;
+    }
+
+    // Adds the vertices of other
+    void unite(const VertexSelection& other);
+
+    int count() const;
+    bool empty() const;
+    int size() const { return num_vertices; }
+
+    // Calls f(first, count) for every run of consecutive selected vertices,
+    // in increasing order
+    template <typename F>
+    void forEachRun(F&& f) const
+    {
+        int run_first = -1;
+        for (int w = 0; w < (int)words.size(); ++w) {
+            std::uint64_t word = words[w];
+            int bit = 0;
+            while (bit < 64) {
+                // Skip to the next change between selected and unselected
+                std::uint64_t remaining = (run_first < 0 ? word : ~word) >> bit;
+                if (remaining == 0) {
+                    break;
+                }
+                bit += std::countr_zero(remaining);
+
+                if (run_first < 0) {
+                    run_first = w * 64 + bit;
+                } else {
+                    f(run_first, w * 64 + bit - run_first);
+                    run_first = -1;
+                }
+            }
+        }
+
+        if (run_first >= 0) {
+            f(run_first, num_vertices - run_first);
+        }
+    }
+
+private:
+    std::vector<std::uint64_t> words;
+    int num_vertices = 0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "2dcurves/Curve.h"
+
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+namespace curves{
+
+    // Number of uniformly spaced parameters in an arc length table
+    constexpr int arc_length_table_size = 512;
+
+    // Cumulative arc length of the curve, entry j is the length from t = 0
+    // to t = j / (arc_length_table_size - 1). The table is cached in the
+    // curve and only rebuilt after an edit.
+    const std::vector<float>& arc_length_table(Curve& curve);
+
+    float curve_length(Curve& curve);
+
+    // Parameter at which the arc length from the start of the curve is
+    // length, by binary search in the table
+    float parameter_at_length(const std::vector<float>& arc_lengths, float length);
+
+    glm::vec2 point_at_length(Curve& curve, float length);
+
+    // num_samples points evenly spaced along the curve
+    void evaluate_curve_by_arc_length(Curve& curve, int num_samples, glm::vec2* out);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "2dcurves/Curve.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+namespace curves{
+
+    // Operations on Bézier control polygons in homogeneous coordinates
+    // (w x, w y, w), which handle polynomial and rational pieces alike.
+
+    // The operations below write into caller-provided arrays and never
+    // allocate, so they can run inside subdivision loops. Degrees are at
+    // most max_bezier_degree.
+
+    constexpr int max_bezier_degree = 63;
+
+    glm::vec2 project(glm::vec3 point);
+
+    glm::vec3 lift(const Vertex& vertex);
+
+    // Splits the piece of the given degree at s with de Casteljau. left and
+    // right receive degree + 1 points each and may alias points.
+    void split_bezier(const glm::vec3* points, int degree, float s, glm::vec3* left, glm::vec3* right);
+
+    // Same piece with one more degree, out receives degree + 2 points and
+    // must not alias points
+    void elevate_bezier(const glm::vec3* points, int degree, glm::vec3* out);
+
+    // Piece of one degree less whose elevation is closest to points in the
+    // least-squares sense, keeping both end points. out receives degree
+    // points and must not alias points. Needs degree >= 2.
+    void reduce_bezier(const glm::vec3* points, int degree, glm::vec3* out);
+
+    // Point, first and second derivative of the projected piece at s
+    void evaluate_bezier_derivatives(
+        const glm::vec3* points,
+        int degree,
+        float s,
+        glm::vec2& point,
+        glm::vec2& first_derivative,
+        glm::vec2& second_derivative
+    );
+
+    // Bézier pieces of a curve, degree + 1 points each. Piece k spans the
+    // normalized parameters [breaks[k], breaks[k + 1]]. A NURBS curve is
+    // split at its knots, a Bézier curve gives a single piece. Returns the
+    // degree of the pieces.
+    int bezier_pieces(const Curve& curve, std::vector<glm::vec3>& points, std::vector<float>& breaks);
+
+    // Same for a curve whose vertices are stored outside control_vertices
+    int bezier_pieces(
+        const Curve& curve,
+        const Vertex* vertices,
+        std::vector<glm::vec3>& points,
+        std::vector<float>& breaks
+    );
+}
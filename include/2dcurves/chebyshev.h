@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+
+namespace curves{
+
+    // Polynomial Bézier curves in the Chebyshev basis,
+    // p(t) = sum c_k T_k(2t - 1) for k = 0, ..., degree. Unlike the
+    // Bernstein table, evaluation needs no binomial coefficients and no
+    // table per degree and sample count, so it scales to degrees of
+    // several hundred. Coefficients are kept in double, callers subtract
+    // an origin from the control points first as for the other evaluators.
+
+    constexpr int max_chebyshev_degree = 512;
+
+    // Coefficients of the curve with degree + 1 control points, by
+    // interpolation at degree + 1 Chebyshev nodes, O(degree^2)
+    void bernstein_to_chebyshev(const glm::dvec2* points, int degree, glm::dvec2* coefficients);
+
+    // Control points of the curve with degree + 1 coefficients, with the
+    // Clenshaw recurrence carried out on Bernstein polynomials, O(degree^2).
+    // Ill-conditioned in any arithmetic: the Bernstein coefficients of T_k
+    // reach 2^k, so rounding errors of the coefficients grow by as much and
+    // round trips lose all precision past degree 40 or so.
+    void chebyshev_to_bernstein(const glm::dvec2* coefficients, int degree, glm::dvec2* points);
+
+    // Point at t with the Clenshaw recurrence, O(degree)
+    glm::dvec2 evaluate_chebyshev(const glm::dvec2* coefficients, int degree, double t);
+
+    // num_samples points at uniform parameters in [0, 1], O(num_samples * degree)
+    void evaluate_chebyshev_curve(const glm::dvec2* coefficients, int degree, int num_samples, glm::vec2* out);
+
+    // Parameter of node j of num_nodes, in increasing order. The nodes are
+    // the Chebyshev points of the first kind and exclude the end points.
+    double chebyshev_node(int j, int num_nodes);
+
+    // Points at the num_nodes Chebyshev nodes by a fast cosine transform,
+    // O(num_nodes * log(num_nodes)) whatever the degree. num_nodes must be
+    // a power of two, at least 2 and larger than degree.
+    void evaluate_chebyshev_nodes(const glm::dvec2* coefficients, int degree, int num_nodes, glm::vec2* out);
+}
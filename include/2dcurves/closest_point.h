@@ -0,0 +1,24 @@
+#pragma once
+
+#include "2dcurves/Curve.h"
+#include "2dcurves/CurveHierarchy.h"
+
+#include <glm/vec2.hpp>
+
+namespace curves{
+
+    struct ClosestPoint
+    {
+        float t;
+        glm::vec2 point;
+        float distance;
+    };
+
+    // Hierarchy of the curve, cached in the curve and rebuilt after edits
+    const CurveHierarchy& curve_hierarchy(Curve& curve);
+
+    // Closest point of the curve to point. Subtrees whose boxes are farther
+    // than the best candidate so far are pruned, and the candidate of each
+    // visited leaf is refined with Newton iterations.
+    ClosestPoint closest_point(Curve& curve, glm::vec2 point);
+}
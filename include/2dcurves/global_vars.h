@@ -1,15 +1,21 @@
 #pragma once
 
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
 #include "2dcurves/Vertex.h"
 
 #include <vector>
 
 enum class mode;
 enum class visibility;
+enum class evaluation_precision;
 
 // Global variables
 extern std::vector<Vertex> control_vertices;
+extern std::vector<Curve> scene_curves;
 extern mode active_mode;
 extern visibility active_visibility;
 extern int num_samples;
-extern std::vector<float> t_samples;
\ No newline at end of file
+extern bool arc_length_sampling;
+extern evaluation_precision sample_precision;
+extern Camera camera;
\ No newline at end of file
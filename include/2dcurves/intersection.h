@@ -0,0 +1,33 @@
+#pragma once
+
+#include "2dcurves/Curve.h"
+
+#include <glm/vec2.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace curves{
+
+    struct Intersection
+    {
+        int curve_a;
+        int curve_b;
+        float t_a;
+        float t_b;
+        glm::vec2 point;
+    };
+
+    // Intersections between two curves. Pairs of nodes of their subdivision
+    // hierarchies are discarded when their boxes are disjoint or when a fat
+    // line around one piece separates it from the other. Candidates from
+    // pairs of flat leaves are refined with Newton iterations.
+    void intersect_curves(int curve_a, int curve_b, std::vector<Intersection>& out);
+
+    // Pairs of curves whose bounds overlap, from a sweep and prune over the
+    // x extents of the boxes
+    void overlapping_curve_pairs(const std::vector<Curve>& curves, std::vector<std::pair<int, int>>& out);
+
+    // Intersections between all pairs of curves of the scene
+    void scene_intersections(std::vector<Intersection>& out);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "2dcurves/AABB.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/vec2.hpp>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace curves{
+
+    // Appends to out a polyline that stays within tolerance (world units)
+    // of the curve. Bézier pieces are halved until their control polygon
+    // lies within tolerance of its chord, which bounds the distance to the
+    // curve since positive weights keep it inside the polygon's hull.
+    // vertices holds the num_vertices vertices of the curve.
+    void flatten_curve(const Curve& curve, const Vertex* vertices, float tolerance, std::vector<glm::vec2>& out);
+
+    enum class polyline_format {binary, svg, csv};
+
+    // Streams polylines to out as they are written, so memory use does not
+    // grow with the number of curves.
+    //
+    // binary: "2DPL", uint32 version, then per polyline uint32 curve index,
+    //         uint32 point count and the points as float32 x, y, all in
+    //         the byte order of the host
+    // svg:    one <polyline> per curve, view is the region shown
+    // csv:    curve,point,x,y rows
+    class PolylineWriter
+    {
+    public:
+        PolylineWriter(std::ostream& out, polyline_format format, const AABB& view);
+
+        void write(int curve_index, const Curve& curve, const std::vector<glm::vec2>& points);
+
+        // Closes the document, call once after the last polyline
+        void finish();
+
+        int polylineCount() const;
+        long long pointCount() const;
+
+    private:
+        std::ostream& out;
+        polyline_format format;
+        int num_polylines = 0;
+        long long num_points = 0;
+    };
+
+    // Flattens every curve of a scene file (see scene_file.h) into writer,
+    // one curve at a time. Returns false if the file is malformed, after
+    // writing the curves that preceded the error.
+    bool export_polylines(std::istream& scene, float tolerance, PolylineWriter& writer);
+}
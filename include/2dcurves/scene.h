@@ -0,0 +1,107 @@
+#pragma once
+
+#include "2dcurves/AABB.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/VertexSelection.h"
+
+#include <glm/mat3x3.hpp>
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+struct EditRecord;
+
+namespace curves{
+
+    // Scene mutations. They keep the bounds and dirty flags of the curves
+    // and the culling hierarchy up to date, so edits should go through them
+    // rather than through control_vertices directly.
+
+    // Appends a vertex to the active (last) curve
+    void add_vertex(glm::vec2 position);
+
+    // Removes the last vertex of the active curve, if any
+    void remove_last_vertex();
+
+    // vertex_index is an index into control_vertices within curve_index
+    void move_vertex(int curve_index, int vertex_index, glm::vec2 position);
+
+    void set_vertex_weight(int curve_index, int vertex_index, float weight);
+
+    // An empty knot vector turns the curve back into a Bézier curve. Adding
+    // or removing vertices of a NURBS curve resets its knots to a clamped
+    // uniform vector of the same degree.
+    void set_curve_knots(int curve_index, std::vector<float> knots);
+
+    void start_new_curve();
+
+    // Degree changes of the active curve, for Bézier curves only. Elevation
+    // keeps the shape, up to max_bezier_degree, the limit of drawing and of
+    // binomial_coefficient. Reduction is a least-squares fit that keeps the
+    // end points. Return false if the curve does not qualify.
+    bool elevate_degree();
+    bool reduce_degree();
+
+    // Splits the active Bézier curve at t in (0, 1). The second half
+    // becomes a new active curve with the same appearance.
+    bool split_curve(float t);
+
+    // Undoable, the old scene is kept aside rather than destroyed
+    void clear_scene();
+
+    // Clears the scene. The mutations until end_scene_replacement build a
+    // new one, undone and redone as a whole rather than recorded one by one.
+    void begin_scene_replacement();
+    void end_scene_replacement();
+
+    // Undo history of the mutations above. Those between begin_edit and
+    // end_edit, which nest, form one step, any other is a step of its own.
+    // Undo and redo do nothing while a step is open and return whether
+    // there was a step to apply.
+    void begin_edit();
+    void end_edit();
+    bool undo();
+    bool redo();
+
+    // Forgets the undo history
+    void clear_edit_history();
+
+    // observer sees every mutation above as it is applied, as the record
+    // the journal holds for it and whether it applies forwards, false when
+    // undone. record is nullptr once the scene was replaced as a whole.
+    // Pass nullptr to stop observing.
+    void set_edit_observer(void (*observer)(const EditRecord* record, bool forward));
+
+    // Maps the selected vertices by the 2D affine transform, in one pass
+    // over control_vertices. Only the curves holding them are marked dirty,
+    // and translations move the cached samples instead where they can, as
+    // move_vertex does. One undo step.
+    void transform_vertices(const VertexSelection& selection, const glm::mat3& transform);
+
+    // Applies a record seen by the observer again, to replay a log. It is
+    // not added to the undo history.
+    void apply_edit(const EditRecord& record, bool forward);
+
+    // Replaces the scene with num_curves random curves inside [-1, 1]^2,
+    // used to stress the renderer
+    void generate_random_scene(int num_curves, int num_vertices, float width, unsigned int seed);
+
+    // Curve closest to point if it is within radius, -1 otherwise
+    int pick_curve(glm::vec2 point, float radius);
+
+    // Adds the vertices inside box, or inside the closed polygon lasso by
+    // the even-odd rule, to selection. Only the curves whose bounds overlap
+    // the region are searched.
+    void select_vertices_in_box(const AABB& box, VertexSelection& selection);
+    void select_vertices_in_lasso(const std::vector<glm::vec2>& lasso, VertexSelection& selection);
+
+    // Bounds of the selected vertices
+    AABB selection_bounds(const VertexSelection& selection);
+
+    // Sets curve_flag_selected on the curves holding selected vertices and
+    // clears it on the others
+    void flag_selected_curves(const VertexSelection& selection);
+
+    // Indices of the curves whose bounds intersect the view of camera
+    void visible_curves(const Camera& camera, std::vector<int>& out);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "2dcurves/Curve.h"
+#include "2dcurves/Vertex.h"
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace curves{
+
+    // Plain text scene files:
+    //
+    //   2dcurves 1
+    //   curve <num_vertices> <num_knots> <r> <g> <b> <a> <width>
+    //   <x> <y> <weight>            one line per vertex
+    //   <knot> <knot> ...           num_knots values, NURBS curves only
+    //
+    // Curves are read one at a time, so tools can stream files that do not
+    // fit in memory. Curves whose Bézier pieces would exceed
+    // max_bezier_degree are rejected, in both formats.
+
+    void write_scene_header(std::ostream& out);
+
+    // vertices holds the num_vertices vertices of the curve, first_vertex
+    // is ignored
+    void write_curve(std::ostream& out, const Curve& curve, const Vertex* vertices);
+
+    // Writes the curves of the scene, skipping empty ones
+    void write_scene(std::ostream& out);
+
+    class SceneReader
+    {
+    public:
+        // Reads the header, failed() tells whether it was valid
+        explicit SceneReader(std::istream& in);
+
+        // Reads the next curve into curve, with first_vertex = 0, and its
+        // vertices. Returns false at the end of the input or on a malformed
+        // curve, after which failed() is set.
+        bool next(Curve& curve, std::vector<Vertex>& vertices);
+
+        bool failed() const;
+
+        // Number of curves read so far
+        int curveCount() const;
+
+    private:
+        std::istream& in;
+        bool has_failed = false;
+        int num_curves = 0;
+
+        bool fail(const char* message);
+    };
+
+    // Replaces the scene with the curves of a file. Returns false if the
+    // file is malformed, in which case the scene is left unchanged.
+    bool load_scene(std::istream& in);
+
+    // Binary scene files, in native byte order. Unlike the text format they
+    // keep empty curves, so curve indices survive a round trip, which the
+    // snapshots of the edit log rely on.
+    //
+    //   "2DCB" <version: u32> <num_curves: u32>
+    //   per curve: <num_vertices: u32> <num_knots: u32> <r g b a width: f32>
+    //              <x y weight: f32> per vertex, <knot: f32> per knot
+    void write_scene_binary(std::ostream& out);
+
+    // Same as load_scene for binary files
+    bool load_scene_binary(std::istream& in);
+}
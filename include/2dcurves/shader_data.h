@@ -0,0 +1,86 @@
+#pragma once
+
+#include "2dcurves/Camera.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace curves{
+
+    // Binding points of the buffer blocks declared in the shaders
+    constexpr unsigned int frame_block_binding = 0;
+    constexpr unsigned int curve_block_binding = 1;
+    constexpr unsigned int sample_block_binding = 2;
+    constexpr unsigned int control_point_block_binding = 3;
+    constexpr unsigned int tessellation_job_block_binding = 4;
+    constexpr unsigned int previous_sample_block_binding = 5;
+
+    // Vertex attribute holding the index of the curve being drawn
+    constexpr unsigned int draw_id_attribute = 1;
+
+    // Mirrors the std140 `Frame` uniform block
+    struct FrameData
+    {
+        glm::mat4 view_projection;
+        glm::vec2 viewport_size;
+        float time;
+        float padding;
+    };
+
+    // Mirrors one std430 `CurveRecord` of the `Curves` storage block.
+    // origin is the sample origin of the curve relative to the camera, the
+    // shaders add it to the curve's samples and control vertices.
+    struct CurveRecord
+    {
+        glm::vec4 color;
+        float width;
+        unsigned int flags;
+        glm::vec2 origin;
+    };
+
+    // Mirrors one std430 `TessellationJob` of the `Jobs` storage block of
+    // the tessellation compute shader. A job evaluates the Bézier curve of
+    // num_points control points into num_samples samples, or copies them
+    // from source_sample of the previous sample buffer.
+    struct TessellationJob
+    {
+        unsigned int first_point;
+        unsigned int num_points;
+        unsigned int first_sample;
+        unsigned int num_samples;
+        unsigned int source_sample;
+    };
+
+    // source_sample of the jobs that evaluate
+    constexpr unsigned int evaluate_job = ~0u;
+
+    static_assert(sizeof(FrameData) == 80);
+    static_assert(sizeof(CurveRecord) == 32);
+    static_assert(sizeof(TessellationJob) == 20);
+
+    void create_shader_data_buffers(unsigned int& frame_ubo, unsigned int& curve_ssbo);
+
+    // Bytes written to buffer objects from the CPU, counted by the functions
+    // writing them for the statistics HUD. Copies on the GPU do not count.
+    void count_uploaded_bytes(std::size_t bytes);
+
+    // Bytes counted since the last call
+    std::size_t take_uploaded_bytes();
+
+    void upload_frame_data(unsigned int frame_ubo, const FrameData& frame);
+
+    // One record per curve of scene_curves, seen by camera
+    void make_curve_records(const Camera& camera, std::vector<CurveRecord>& records);
+
+    // Writes one record per curve of scene_curves and makes sure the draw
+    // id buffer holds an id for each of them. Goes after the tessellation
+    // update, which may move the sample origins.
+    void upload_curve_records(unsigned int curve_ssbo, unsigned int draw_id_vbo);
+
+    // Same with records made earlier, possibly on another thread
+    void upload_curve_records(unsigned int curve_ssbo, unsigned int draw_id_vbo, const std::vector<CurveRecord>& records);
+}
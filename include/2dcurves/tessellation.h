@@ -0,0 +1,131 @@
+#pragma once
+
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+// Arithmetic of the tessellations: float, double, or compensated de
+// Casteljau in double, about as accurate as twice double precision for
+// Bézier curves of high degree (NURBS curves use double)
+enum class evaluation_precision {float32, float64, compensated};
+
+namespace curves{
+
+    // LOD level k has min_lod_samples * 4^k samples: 16, 64, ..., 16384
+    constexpr int min_lod_samples = 16;
+
+    constexpr int lod_level_samples(int level)
+    {
+        return min_lod_samples << (2 * level);
+    }
+
+    constexpr int max_lod_samples = lod_level_samples(num_lod_levels - 1);
+
+    // Bernstein basis of the given degree at num_samples uniform parameters
+    // in [0, 1]. Column i, table[i * num_samples + j], holds B_i(t_j) so that
+    // evaluation loops run over contiguous samples. Tables are built on
+    // first use and kept for the lifetime of the program.
+    const std::vector<float>& bernstein_basis_table(int degree, int num_samples);
+
+    // Nonzero B-spline basis functions at num_samples uniform parameters
+    // over the domain of a knot vector. Sample j depends on the vertices
+    // spans[j] - degree, ..., spans[j], with weights
+    // values[j * (degree + 1)], ..., values[j * (degree + 1) + degree].
+    struct BSplineBasisTable
+    {
+        int degree;
+        std::vector<int> spans;
+        std::vector<float> values;
+    };
+
+    // The most recently used tables are cached, a table stays valid until
+    // the next call
+    const BSplineBasisTable& bspline_basis_table(const std::vector<float>& knots, int degree, int num_samples);
+
+    // Clamped knot vector with uniformly spaced interior knots
+    std::vector<float> clamped_uniform_knots(int num_vertices, int degree);
+
+    // Degree of a curve with a usable (clamped, non-decreasing, no interior
+    // knot repeated more than degree times) knot vector, 0 for Bézier curves
+    int nurbs_degree(const Curve& curve);
+
+    // Coarsest LOD level giving a curve spanning screen_extent NDC units at
+    // least num_samples samples per NDC unit
+    int lod_level(float screen_extent);
+
+    // LOD level of a curve seen by camera, -1 if it has no vertices
+    int curve_lod_level(const Curve& curve, const Camera& camera);
+
+    // Samples of the curve in the sample buffer at sample_offset, as laid
+    // out by the last tessellation update
+    inline int resident_samples(const Curve& curve)
+    {
+        return curve.lod_level < 0 ? 0 : lod_level_samples(curve.lod_level);
+    }
+
+    void evaluate_bezier_curve(const Vertex* vertices, int num_vertices, int num_samples, glm::vec2* out);
+
+    // Evaluates in homogeneous coordinates (w x, w y, w) with one divide per
+    // sample
+    void evaluate_rational_bezier_curve(const Vertex* vertices, int num_vertices, int num_samples, glm::vec2* out);
+
+    void evaluate_nurbs_curve(
+        const Vertex* vertices,
+        int num_vertices,
+        const std::vector<float>& knots,
+        int num_samples,
+        glm::vec2* out
+    );
+
+    // Picks the evaluator matching the curve type and weights
+    void evaluate_curve(const Curve& curve, int num_samples, glm::vec2* out);
+
+    // Evaluates the curve at num_samples uniform parameters in arithmetic T,
+    // float or double, and writes the points minus origin. With an origin
+    // on the curve the rounding error scales with the size of the curve
+    // rather than with its distance to the world origin, so scenes far from
+    // it do not jitter.
+    template <typename T>
+    void evaluate_curve_relative(const Curve& curve, glm::vec2 origin, int num_samples, glm::vec2* out);
+
+    extern template void evaluate_curve_relative<float>(const Curve&, glm::vec2, int, glm::vec2*);
+    extern template void evaluate_curve_relative<double>(const Curve&, glm::vec2, int, glm::vec2*);
+
+    // Same with compensated de Casteljau, O(samples * degree^2)
+    void evaluate_curve_compensated(const Curve& curve, glm::vec2 origin, int num_samples, glm::vec2* out);
+
+    // Evaluates relative to origin in the given precision
+    void evaluate_curve_samples(
+        const Curve& curve,
+        glm::vec2 origin,
+        evaluation_precision precision,
+        int num_samples,
+        glm::vec2* out
+    );
+
+    // Moves the cached samples of a curve whose vertex (index within the
+    // curve) moved by delta. Each sample moves by delta times the basis
+    // function of the vertex, one scaled column of the basis table, which
+    // costs O(samples) instead of O(samples * degree) for a re-evaluation.
+    // Returns false if the samples have to be re-evaluated instead: they are
+    // stale, arc-length spaced or belong to a rational Bézier curve.
+    bool apply_vertex_delta(Curve& curve, int vertex, glm::vec2 delta);
+
+    // Point of the curve at t in [0, 1], which spans the whole parameter
+    // domain for NURBS curves
+    glm::vec2 evaluate_curve_point(const Curve& curve, float t);
+
+    // Picks the LOD level of each visible curve from its size on screen,
+    // evaluating it if it is not cached, and assigns the offsets in the
+    // sample buffer, which only holds visible curves. Returns true if the
+    // layout of the sample buffer changed.
+    bool update_tessellations(const Camera& camera, const std::vector<int>& visible_curves);
+
+    // Makes the next update_tessellations report a layout change, after
+    // the sample buffer was written by something else
+    void invalidate_tessellation_layout();
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "2dcurves/Camera.h"
+#include "2dcurves/VertexSelection.h"
+
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
 
@@ -9,13 +12,31 @@ namespace curves{
 
     glm::vec2 get_cursor_position_NDC(GLFWwindow* window);
 
+    glm::vec2 get_cursor_position_world(GLFWwindow* window, const Camera& camera);
+
     std::vector<float> linspace(float a, float b, int n);
 
+    // Exact for n up to max_bezier_degree
     long long binomial_coefficient(int n, int k);
 
     float bernstein_polynomial(int n, int i, float t);
 
-    void draw_bezier_curve(unsigned int vao, unsigned int vbo);
+    // Re-evaluates the visible curves that need it and uploads their samples
+    void upload_bezier_curves(unsigned int vbo, const std::vector<int>& visible_curves);
+
+    // Draws the uploaded curves as 1 pixel line strips
+    void draw_bezier_curve(unsigned int vao, const std::vector<int>& visible_curves);
+
+    // Draws the uploaded curves as anti-aliased lines of the width of each
+    // curve. vao only needs the draw id attribute.
+    void draw_wide_bezier_curve(unsigned int vao, unsigned int vbo, const std::vector<int>& visible_curves);
+
+    void draw_control_polygon(unsigned int vao, unsigned int vbo, const std::vector<int>& visible_curves);
+
+    // Draws the selected vertices of the visible curves as points, from the
+    // buffer filled by draw_control_polygon
+    void draw_selected_vertices(unsigned int vao, const std::vector<int>& visible_curves, const VertexSelection& selection);
 
-    void draw_control_polygon(unsigned int vao, unsigned int vbo);
+    // Draws a closed outline through points given in world coordinates
+    void draw_selection_outline(unsigned int vao, unsigned int vbo, const std::vector<glm::vec2>& outline);
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "2dcurves/Camera.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+
+namespace curves{
+
+    namespace {
+        constexpr float min_zoom = 1e-4f;
+        constexpr float max_zoom = 1e6f;
+    }
+
+    glm::mat4 view_projection(const Camera& camera)
+    {
+        glm::mat4 res(1.0f);
+        res[0][0] = camera.zoom;
+        res[1][1] = camera.zoom;
+
+        return res;
+    }
+
+    glm::vec2 camera_relative(const Camera& camera, glm::vec2 world)
+    {
+        return glm::vec2(glm::dvec2(world) - camera.center);
+    }
+
+    glm::vec2 ndc_to_world(const Camera& camera, glm::vec2 position_NDC)
+    {
+        return glm::vec2(camera.center + glm::dvec2(position_NDC) / (double)camera.zoom);
+    }
+
+    void zoom_camera(Camera& camera, glm::vec2 anchor_NDC, float factor)
+    {
+        glm::dvec2 anchor_world = camera.center + glm::dvec2(anchor_NDC) / (double)camera.zoom;
+
+        camera.zoom = std::clamp(camera.zoom * factor, min_zoom, max_zoom);
+        camera.center = anchor_world - glm::dvec2(anchor_NDC) / (double)camera.zoom;
+    }
+
+    void pan_camera(Camera& camera, glm::vec2 delta_NDC)
+    {
+        camera.center -= glm::dvec2(delta_NDC) / (double)camera.zoom;
+    }
+}
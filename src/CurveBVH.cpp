@@ -0,0 +1,126 @@
+#include "2dcurves/CurveBVH.h"
+#include "2dcurves/AABB.h"
+#include "2dcurves/Curve.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+void CurveBVH::build(const std::vector<Curve>& curves)
+{
+    nodes.clear();
+    curve_indices.resize(curves.size());
+    std::iota(curve_indices.begin(), curve_indices.end(), 0);
+    leaf_of_curve.assign(curves.size(), -1);
+
+    if (!curves.empty()) {
+        nodes.reserve(2 * (curves.size() / max_leaf_size + 1));
+        buildNode(curves, -1, 0, curves.size());
+    }
+}
+
+int CurveBVH::buildNode(const std::vector<Curve>& curves, int parent, int first, int count)
+{
+    int index = nodes.size();
+    nodes.push_back(Node());
+    nodes[index].parent = parent;
+
+    AABB bounds;
+    AABB centers;
+    for (int i = first; i < first + count; ++i) {
+        const AABB& curve_bounds = curves[curve_indices[i]].bounds;
+        bounds.expand(curve_bounds);
+        if (!curve_bounds.empty()) {
+            centers.expand(curve_bounds.center());
+        }
+    }
+    nodes[index].bounds = bounds;
+
+    if (count <= max_leaf_size) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        for (int i = first; i < first + count; ++i) {
+            leaf_of_curve[curve_indices[i]] = index;
+        }
+        return index;
+    }
+
+    // Median split along the longest axis of the centers, empty curves
+    // sort to the end
+    int axis = 0;
+    if (!centers.empty() && centers.size().y > centers.size().x) {
+        axis = 1;
+    }
+
+    auto begin = curve_indices.begin() + first;
+    std::nth_element(begin, begin + count / 2, begin + count, [&](int a, int b) {
+        const AABB& bounds_a = curves[a].bounds;
+        const AABB& bounds_b = curves[b].bounds;
+        if (bounds_a.empty() || bounds_b.empty()) {
+            return !bounds_a.empty() && bounds_b.empty();
+        }
+        return bounds_a.center()[axis] < bounds_b.center()[axis];
+    });
+
+    int left = buildNode(curves, index, first, count / 2);
+    int right = buildNode(curves, index, first + count / 2, count - count / 2);
+    nodes[index].left = left;
+    nodes[index].right = right;
+
+    return index;
+}
+
+void CurveBVH::refit(const std::vector<Curve>& curves, int curve_index)
+{
+    int node = leaf_of_curve[curve_index];
+
+    // Leaf bounds from its curves
+    AABB bounds;
+    for (int i = nodes[node].first; i < nodes[node].first + nodes[node].count; ++i) {
+        bounds.expand(curves[curve_indices[i]].bounds);
+    }
+    nodes[node].bounds = bounds;
+
+    // Walk up while the bounds keep changing
+    node = nodes[node].parent;
+    while (node != -1) {
+        AABB merged = nodes[nodes[node].left].bounds;
+        merged.expand(nodes[nodes[node].right].bounds);
+
+        if (merged.min == nodes[node].bounds.min && merged.max == nodes[node].bounds.max) {
+            break;
+        }
+
+        nodes[node].bounds = merged;
+        node = nodes[node].parent;
+    }
+}
+
+void CurveBVH::query(const std::vector<Curve>& curves, const AABB& view, std::vector<int>& out) const
+{
+    if (nodes.empty()) {
+        return;
+    }
+
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node& node = nodes[stack[--stack_size]];
+        if (!node.bounds.overlaps(view)) {
+            continue;
+        }
+
+        if (node.left == -1) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if (curves[curve_indices[i]].bounds.overlaps(view)) {
+                    out.push_back(curve_indices[i]);
+                }
+            }
+        } else {
+            stack[stack_size++] = node.right;
+            stack[stack_size++] = node.left;
+        }
+    }
+}
@@ -0,0 +1,233 @@
+#include "2dcurves/EditJournal.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Payloads start on 8 byte boundaries
+    std::size_t padded(std::size_t size)
+    {
+        return (size + 7) & ~std::size_t(7);
+    }
+
+    bool overlaps(std::size_t offset, std::size_t size, std::size_t other_offset, std::size_t other_size)
+    {
+        return offset < other_offset + other_size && other_offset < offset + size;
+    }
+}
+
+EditJournal::EditJournal(std::size_t arena_capacity, std::size_t external_capacity, void (*discard)(const EditRecord&))
+    : arena_capacity(arena_capacity), external_capacity(external_capacity), discard(discard)
+{
+}
+
+void EditJournal::beginStep()
+{
+    if (step_depth++ == 0) {
+        step_first = -1;
+        step_overflowed = false;
+        mergeable_moves.clear();
+    }
+}
+
+void EditJournal::endStep()
+{
+    if (step_depth == 0) {
+        return;
+    }
+
+    if (--step_depth == 0) {
+        step_first = -1;
+        step_overflowed = false;
+        mergeable_moves.clear();
+    }
+}
+
+bool EditJournal::append(edit_type type, const void* payload, std::size_t size, std::size_t external_size)
+{
+    EditRecord incoming{type, static_cast<const unsigned char*>(payload), size};
+    if (step_overflowed) {
+        discard(incoming);
+        return false;
+    }
+
+    while (entries.size() > num_applied) {
+        dropBack();
+    }
+
+    std::size_t arena_size = padded(size);
+    if (arena_size > arena_capacity || external_size > external_capacity) {
+        std::cerr << "ERROR::JOURNAL::RECORD_TOO_LARGE\n"
+                  << "Undo history cleared" << std::endl;
+        clear();
+        discard(incoming);
+        step_overflowed = step_depth > 0;
+        return false;
+    }
+
+    // The arena is only allocated once something is recorded
+    if (arena.empty()) {
+        arena.resize(arena_capacity);
+    }
+
+    std::size_t offset = 0;
+    if (!entries.empty()) {
+        offset = entries.back().offset + padded(entries.back().size);
+    }
+
+    // Drops the oldest steps in the way. Free space runs from the end of
+    // the newest record to the start of the oldest, so only the oldest
+    // needs checking. The records from offset to the end are the oldest
+    // when wrapping around.
+    bool wrap = offset + arena_size > arena_capacity;
+    std::size_t wrap_offset = offset;
+    if (wrap) {
+        offset = 0;
+    }
+
+    while (!entries.empty()) {
+        const Entry& oldest = entries.front();
+        bool in_the_way = (wrap && oldest.offset >= wrap_offset)
+            || overlaps(offset, arena_size, oldest.offset, padded(oldest.size))
+            || external_bytes + external_size > external_capacity;
+        if (!in_the_way) {
+            break;
+        }
+
+        // The open step alone does not fit
+        if (step_first == 0) {
+            std::cerr << "ERROR::JOURNAL::STEP_TOO_LARGE\n"
+                      << "Undo history cleared" << std::endl;
+            clear();
+            discard(incoming);
+            step_overflowed = true;
+            return false;
+        }
+
+        dropFront();
+    }
+
+    std::memcpy(arena.data() + offset, payload, size);
+
+    bool continues = step_depth > 0 && step_first >= 0;
+    if (step_depth > 0 && step_first < 0) {
+        step_first = entries.size();
+    }
+
+    entries.push_back(Entry{(std::uint32_t)offset, (std::uint32_t)size, external_size, type, continues});
+    num_applied = entries.size();
+    arena_bytes += arena_size;
+    external_bytes += external_size;
+
+    // Moves may only be merged into records that nothing else follows
+    if (type == edit_type::add_vertex) {
+        VertexEdit edit;
+        std::memcpy(&edit, payload, sizeof(edit));
+        mergeable_moves[edit.vertex] = entries.size() - 1;
+    } else if (type != edit_type::move_vertex) {
+        mergeable_moves.clear();
+    }
+
+    return true;
+}
+
+void EditJournal::appendMove(const VertexEdit& edit)
+{
+    auto it = mergeable_moves.find(edit.vertex);
+    if (it != mergeable_moves.end()) {
+        unsigned char* payload = arena.data() + entries[it->second].offset;
+
+        VertexEdit merged;
+        std::memcpy(&merged, payload, sizeof(merged));
+        merged.after_position = edit.after_position;
+        merged.after_weight = edit.after_weight;
+        std::memcpy(payload, &merged, sizeof(merged));
+        return;
+    }
+
+    if (append(edit_type::move_vertex, &edit, sizeof(edit))) {
+        mergeable_moves[edit.vertex] = entries.size() - 1;
+    }
+}
+
+bool EditJournal::undo(std::vector<EditRecord>& records)
+{
+    records.clear();
+    if (step_depth > 0 || num_applied == 0) {
+        return false;
+    }
+
+    mergeable_moves.clear();
+
+    bool continues;
+    do {
+        const Entry& entry = entries[--num_applied];
+        records.push_back(record(entry));
+        continues = entry.continues;
+    } while (continues && num_applied > 0);
+
+    return true;
+}
+
+bool EditJournal::redo(std::vector<EditRecord>& records)
+{
+    records.clear();
+    if (step_depth > 0 || num_applied == entries.size()) {
+        return false;
+    }
+
+    mergeable_moves.clear();
+
+    do {
+        records.push_back(record(entries[num_applied++]));
+    } while (num_applied < entries.size() && entries[num_applied].continues);
+
+    return true;
+}
+
+void EditJournal::clear()
+{
+    for (const Entry& entry : entries) {
+        discard(record(entry));
+    }
+
+    entries.clear();
+    num_applied = 0;
+    arena_bytes = 0;
+    external_bytes = 0;
+    step_first = -1;
+    mergeable_moves.clear();
+}
+
+EditRecord EditJournal::record(const Entry& entry) const
+{
+    return EditRecord{entry.type, arena.data() + entry.offset, entry.size};
+}
+
+void EditJournal::dropFront()
+{
+    do {
+        const Entry& entry = entries.front();
+        discard(record(entry));
+        arena_bytes -= padded(entry.size);
+        external_bytes -= entry.external_size;
+
+        entries.pop_front();
+        num_applied--;
+        if (step_first > 0) {
+            step_first--;
+        }
+    } while (!entries.empty() && entries.front().continues);
+
+    mergeable_moves.clear();
+}
+
+void EditJournal::dropBack()
+{
+    const Entry& entry = entries.back();
+    discard(record(entry));
+    arena_bytes -= padded(entry.size);
+    external_bytes -= entry.external_size;
+
+    entries.pop_back();
+}
@@ -0,0 +1,321 @@
+#include "2dcurves/EditLog.h"
+#include "2dcurves/EditJournal.h"
+#include "2dcurves/scene.h"
+#include "2dcurves/scene_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char log_magic[4] = {'2', 'D', 'C', 'L'};
+    constexpr std::uint32_t log_version = 1;
+
+    struct LogHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t generation;
+    };
+
+    // Precedes every payload in the log
+    struct RecordHeader
+    {
+        std::uint8_t type;
+        std::uint8_t forward;
+        std::uint16_t reserved;
+        std::uint32_t size;
+        // Of the header fields above and the payload, to detect a record
+        // torn by a crash
+        std::uint32_t checksum;
+    };
+
+    // Bounds the allocation a corrupt size could cause
+    constexpr std::uint32_t max_record_size = 1u << 26;
+
+    // FNV-1a
+    std::uint32_t checksum(const RecordHeader& header, const unsigned char* payload)
+    {
+        std::uint32_t hash = 2166136261u;
+        auto mix = [&](const unsigned char* bytes, std::size_t size) {
+            for (std::size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+        };
+
+        mix(&header.type, 1);
+        mix(&header.forward, 1);
+        mix(reinterpret_cast<const unsigned char*>(&header.size), sizeof(header.size));
+        mix(payload, header.size);
+        return hash;
+    }
+
+    void sync(std::FILE* file)
+    {
+        std::fflush(file);
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    bool sync_path(const std::string& path)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        if (file == nullptr) {
+            return false;
+        }
+        sync(file);
+        std::fclose(file);
+        return true;
+    }
+
+    // Renames from over to and only returns once the rename itself is on
+    // disk, which takes syncing the directory entry on POSIX systems. If
+    // only that sync fails the rename stands and is merely reported, the
+    // log has to follow the new snapshot all the same.
+    void rename_durably(const std::string& from, const std::string& to, std::error_code& error)
+    {
+#ifdef _WIN32
+        std::filesystem::path from_path(from);
+        std::filesystem::path to_path(to);
+        if (!MoveFileExW(from_path.c_str(), to_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            error = std::error_code(GetLastError(), std::system_category());
+        }
+#else
+        std::filesystem::rename(from, to, error);
+        if (error) {
+            return;
+        }
+
+        std::filesystem::path directory = std::filesystem::path(to).parent_path();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        int descriptor = open(directory.c_str(), O_RDONLY);
+        if (descriptor < 0 || fsync(descriptor) != 0) {
+            std::cerr << "ERROR::EDIT_LOG::CANNOT_SYNC " << directory.string() << ": " << std::strerror(errno) << std::endl;
+        }
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+#endif
+    }
+}
+
+EditLog::EditLog(std::string snapshot_path, std::string log_path)
+    : snapshot_path(std::move(snapshot_path)), log_path(std::move(log_path))
+{
+    last_sync = std::chrono::steady_clock::now();
+}
+
+EditLog::~EditLog()
+{
+    closeLog();
+}
+
+bool EditLog::recover()
+{
+    num_replayed = 0;
+
+    std::ifstream snapshot_file(snapshot_path, std::ios::binary);
+    std::uint64_t snapshot_generation = 0;
+    if (!snapshot_file || !snapshot_file.read(reinterpret_cast<char*>(&snapshot_generation), sizeof(snapshot_generation))) {
+        return false;
+    }
+    if (!curves::load_scene_binary(snapshot_file)) {
+        std::cerr << "ERROR::EDIT_LOG::INVALID_SNAPSHOT " << snapshot_path << std::endl;
+        return false;
+    }
+    snapshot_file.close();
+
+    closeLog();
+    generation = snapshot_generation;
+    snapshot_bytes = std::filesystem::file_size(snapshot_path);
+
+    // Replay the records of the snapshot's generation, up to the first
+    // incomplete or corrupt one
+    std::ifstream in(log_path, std::ios::binary);
+    LogHeader header;
+    bool replay = in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && std::memcmp(header.magic, log_magic, sizeof(log_magic)) == 0
+        && header.version == log_version
+        && header.generation == generation;
+
+    if (!replay) {
+        in.close();
+        startLog();
+        curves::clear_edit_history();
+        return true;
+    }
+
+    std::uint64_t valid_bytes = sizeof(header);
+    std::vector<unsigned char> payload;
+    RecordHeader record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.size > max_record_size || record.type >= (std::uint8_t)edit_type::swap_scene) {
+            break;
+        }
+
+        payload.resize(record.size);
+        if (!in.read(reinterpret_cast<char*>(payload.data()), record.size)) {
+            break;
+        }
+        if (checksum(record, payload.data()) != record.checksum) {
+            break;
+        }
+
+        curves::apply_edit(EditRecord{(edit_type)record.type, payload.data(), payload.size()}, record.forward != 0);
+        valid_bytes += sizeof(record) + record.size;
+        num_replayed++;
+    }
+    in.close();
+
+    // Appending after a torn record would make the rest unreadable
+    if (valid_bytes < std::filesystem::file_size(log_path)) {
+        std::filesystem::resize_file(log_path, valid_bytes);
+    }
+
+    log = std::fopen(log_path.c_str(), "ab");
+    if (log == nullptr) {
+        std::cerr << "ERROR::EDIT_LOG::CANNOT_OPEN " << log_path << std::endl;
+    }
+    log_bytes = valid_bytes;
+
+    // The recovered scene is where undo starts from
+    curves::clear_edit_history();
+    return true;
+}
+
+void EditLog::append(const EditRecord& record, bool forward)
+{
+    RecordHeader header{};
+    header.type = (std::uint8_t)record.type;
+    header.forward = forward ? 1 : 0;
+    header.size = record.size;
+    header.checksum = checksum(header, record.payload);
+
+    const unsigned char* header_bytes = reinterpret_cast<const unsigned char*>(&header);
+    buffer.insert(buffer.end(), header_bytes, header_bytes + sizeof(header));
+    buffer.insert(buffer.end(), record.payload, record.payload + record.size);
+}
+
+void EditLog::snapshot()
+{
+    std::uint64_t next_generation = generation + 1;
+
+    // Written aside and renamed over the old snapshot, so a crash leaves
+    // either the old or the new one
+    std::string temporary_path = snapshot_path + ".tmp";
+    {
+        std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&next_generation), sizeof(next_generation));
+        curves::write_scene_binary(out);
+        if (!out) {
+            std::cerr << "ERROR::EDIT_LOG::CANNOT_WRITE " << temporary_path << std::endl;
+            return;
+        }
+    }
+    sync_path(temporary_path);
+
+    // The log below must not be truncated before the rename is durable,
+    // otherwise a crash could leave the old snapshot and an empty log
+    std::error_code error;
+    rename_durably(temporary_path, snapshot_path, error);
+    if (error) {
+        std::cerr << "ERROR::EDIT_LOG::CANNOT_WRITE " << snapshot_path << ": " << error.message() << std::endl;
+        return;
+    }
+    snapshot_bytes = std::filesystem::file_size(snapshot_path);
+
+    // The old log has an older generation from now on, a crash before the
+    // new one is written loses nothing. The buffered records are part of
+    // the snapshot.
+    buffer.clear();
+    closeLog();
+    generation = next_generation;
+    startLog();
+}
+
+void EditLog::flush()
+{
+    // Without a log the records have nowhere to go, holding on to them
+    // would only grow the buffer for the rest of the session
+    if (log == nullptr) {
+        buffer.clear();
+        return;
+    }
+
+    if (!buffer.empty()) {
+        std::fwrite(buffer.data(), 1, buffer.size(), log);
+        std::fflush(log);
+        log_bytes += buffer.size();
+        buffer.clear();
+        unsynced = true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (unsynced && std::chrono::duration<double>(now - last_sync).count() >= sync_interval) {
+        sync(log);
+        unsynced = false;
+        last_sync = now;
+    }
+
+    if (log_bytes > std::max(snapshot_bytes, min_compaction_bytes)) {
+        snapshot();
+    }
+}
+
+void EditLog::startLog()
+{
+    log = std::fopen(log_path.c_str(), "wb");
+    if (log == nullptr) {
+        std::cerr << "ERROR::EDIT_LOG::CANNOT_OPEN " << log_path << std::endl;
+        return;
+    }
+
+    LogHeader header{};
+    std::memcpy(header.magic, log_magic, sizeof(log_magic));
+    header.version = log_version;
+    header.generation = generation;
+    std::fwrite(&header, sizeof(header), 1, log);
+    sync(log);
+
+    log_bytes = sizeof(header);
+    unsynced = false;
+    last_sync = std::chrono::steady_clock::now();
+}
+
+void EditLog::closeLog()
+{
+    if (log == nullptr) {
+        return;
+    }
+
+    if (!buffer.empty()) {
+        std::fwrite(buffer.data(), 1, buffer.size(), log);
+        buffer.clear();
+    }
+    sync(log);
+    std::fclose(log);
+    log = nullptr;
+}
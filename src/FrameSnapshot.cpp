@@ -0,0 +1,66 @@
+#include "2dcurves/FrameSnapshot.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+
+#include <memory>
+#include <vector>
+
+namespace curves{
+
+    std::shared_ptr<FrameSnapshot> make_frame_snapshot(
+        const Camera& camera,
+        const std::vector<int>& visible_curves,
+        bool show_control_polygons,
+        const VertexSelection& selection)
+    {
+        auto snapshot = std::make_shared<FrameSnapshot>();
+        make_curve_records(camera, snapshot->records);
+
+        snapshot->visible_curves = visible_curves;
+        snapshot->samples.reserve(visible_curves.size());
+        for (int c : visible_curves) {
+            Curve& curve = scene_curves[c];
+
+            // Snapshots still drawing keep the old array alive
+            if (curve.needs_upload || !curve.published_samples) {
+                curve.published_samples = std::make_shared<const std::vector<glm::vec2>>(curve.samples);
+                curve.needs_upload = false;
+            }
+            snapshot->samples.push_back(curve.published_samples);
+        }
+
+        if (!show_control_polygons) {
+            return snapshot;
+        }
+
+        snapshot->control_points.resize(control_vertices.size());
+        for (const Curve& curve : scene_curves) {
+            glm::dvec2 origin(curve.sample_origin);
+            for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                snapshot->control_points[i] = glm::vec2(glm::dvec2(control_vertices[i].position) - origin);
+            }
+        }
+
+        for (int c : visible_curves) {
+            const Curve& curve = scene_curves[c];
+            snapshot->control_polygons.push_back(FrameSnapshot::VertexRange{c, curve.first_vertex, curve.num_vertices});
+
+            int end = curve.first_vertex + curve.num_vertices;
+            int i = curve.first_vertex;
+            while (i < end) {
+                if (!selection.contains(i)) {
+                    i++;
+                    continue;
+                }
+
+                int first = i;
+                while (i < end && selection.contains(i)) {
+                    i++;
+                }
+                snapshot->selected_vertices.push_back(FrameSnapshot::VertexRange{c, first, i - first});
+            }
+        }
+
+        return snapshot;
+    }
+}
@@ -0,0 +1,230 @@
+#include "2dcurves/GpuTessellator.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/tessellation.h"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+
+namespace {
+    // Makes buffer hold at least bytes, at least doubling it. Replaces the
+    // buffer object, copying the old contents if keep.
+    void reserve_buffer(unsigned int& buffer, std::size_t& capacity, std::size_t bytes, bool keep)
+    {
+        if (bytes <= capacity) {
+            return;
+        }
+
+        std::size_t new_capacity = std::max(bytes, 2 * capacity);
+        unsigned int new_buffer;
+        glCreateBuffers(1, &new_buffer);
+        glNamedBufferData(new_buffer, new_capacity, NULL, GL_DYNAMIC_DRAW);
+
+        if (keep && capacity > 0) {
+            glCopyNamedBufferSubData(buffer, new_buffer, 0, 0, capacity);
+        }
+        if (buffer != 0) {
+            glDeleteBuffers(1, &buffer);
+        }
+
+        buffer = new_buffer;
+        capacity = new_capacity;
+    }
+}
+
+GpuTessellator::GpuTessellator(const char* computePath)
+    : program(computePath)
+{
+    num_jobs_location = program.getUniformLocation("num_jobs");
+
+    // Storage blocks must not be bound to empty buffers
+    reserve_buffer(point_pool, point_pool_bytes, sizeof(glm::vec4), false);
+    reserve_buffer(job_buffer, job_buffer_bytes, sizeof(curves::TessellationJob), false);
+    reserve_buffer(previous_samples, previous_samples_bytes, sizeof(glm::vec2), false);
+}
+
+GpuTessellator::~GpuTessellator()
+{
+    unsigned int buffers[] = {point_pool, job_buffer, previous_samples};
+    glDeleteBuffers(3, buffers);
+}
+
+void GpuTessellator::update(unsigned int sample_vbo, const std::vector<int>& visible_curves)
+{
+    resident.resize(scene_curves.size(), false);
+
+    // Levels first, a change of the layout means copying the samples that
+    // stay valid
+    bool layout_changed = visible_curves != resident_curves;
+    levels.clear();
+    int offset = 0;
+    for (int c : visible_curves) {
+        const Curve& curve = scene_curves[c];
+        int level = curves::curve_lod_level(curve, camera);
+        levels.push_back(level);
+
+        layout_changed |= level != curve.lod_level || curve.sample_offset != offset;
+        offset += level < 0 ? 0 : curves::lod_level_samples(level);
+    }
+
+    jobs.clear();
+    evaluated_curves.clear();
+
+    offset = 0;
+    for (std::size_t k = 0; k < visible_curves.size(); ++k) {
+        int c = visible_curves[k];
+        Curve& curve = scene_curves[c];
+        int level = levels[k];
+        int num_samples = level < 0 ? 0 : curves::lod_level_samples(level);
+
+        // needs_upload is also set when the scene is swapped back in
+        bool evaluate = curve.dirty || curve.needs_upload || level != curve.lod_level || !resident[c];
+        if (curve.dirty && curve.num_vertices > 0) {
+            curve.sample_origin = control_vertices[curve.first_vertex].position;
+        }
+
+        if (num_samples > 0) {
+            if (evaluate) {
+                evaluated_curves.push_back(c);
+            } else if (layout_changed) {
+                jobs.push_back(curves::TessellationJob{
+                    0, 0, (unsigned int)offset, (unsigned int)num_samples, (unsigned int)curve.sample_offset
+                });
+            }
+        }
+
+        // The samples on the CPU are not kept up to date
+        curve.samples.clear();
+        curve.lod_cache_valid = 0;
+        curve.incremental_updates = 0;
+        curve.dirty = false;
+        curve.needs_upload = false;
+        curve.lod_level = level;
+        curve.sample_offset = offset;
+        offset += num_samples;
+    }
+
+    // Copies read the old layout from a copy of the sample buffer, which
+    // may be reallocated below
+    if (!jobs.empty()) {
+        std::size_t resident_bytes = num_resident_samples * sizeof(glm::vec2);
+        reserve_buffer(previous_samples, previous_samples_bytes, resident_bytes, false);
+        glCopyNamedBufferSubData(sample_vbo, previous_samples, 0, 0, resident_bytes);
+    }
+
+    GLint64 sample_vbo_bytes = 0;
+    glGetNamedBufferParameteri64v(sample_vbo, GL_BUFFER_SIZE, &sample_vbo_bytes);
+    std::size_t needed_bytes = std::max(offset, 1) * sizeof(glm::vec2);
+    if ((std::size_t)sample_vbo_bytes < needed_bytes) {
+        glNamedBufferData(sample_vbo, std::max(needed_bytes, 2 * (std::size_t)sample_vbo_bytes), NULL, GL_DYNAMIC_DRAW);
+    }
+
+    if (layout_changed) {
+        for (int c : resident_curves) {
+            if (c < (int)resident.size()) {
+                resident[c] = false;
+            }
+        }
+        for (int c : visible_curves) {
+            resident[c] = true;
+        }
+        resident_curves = visible_curves;
+        num_resident_samples = offset;
+    }
+
+    // In order of their vertices, so that the control points of
+    // consecutive curves are uploaded together
+    std::sort(evaluated_curves.begin(), evaluated_curves.end());
+    num_evaluated = evaluated_curves.size();
+
+    auto gpu_end = std::stable_partition(evaluated_curves.begin(), evaluated_curves.end(), [](int c) {
+        return scene_curves[c].knots.empty();
+    });
+
+    for (auto it = gpu_end; it != evaluated_curves.end(); ++it) {
+        const Curve& curve = scene_curves[*it];
+        int num_samples = curves::resident_samples(curve);
+        staged_samples.resize(num_samples);
+        curves::evaluate_curve_relative<float>(curve, curve.sample_origin, num_samples, staged_samples.data());
+        glNamedBufferSubData(
+            sample_vbo, curve.sample_offset * sizeof(glm::vec2), num_samples * sizeof(glm::vec2), staged_samples.data()
+        );
+        curves::count_uploaded_bytes(num_samples * sizeof(glm::vec2));
+    }
+    evaluated_curves.erase(gpu_end, evaluated_curves.end());
+
+    uploadControlPoints();
+    for (int c : evaluated_curves) {
+        const Curve& curve = scene_curves[c];
+        jobs.push_back(curves::TessellationJob{
+            (unsigned int)curve.first_vertex,
+            (unsigned int)curve.num_vertices,
+            (unsigned int)curve.sample_offset,
+            (unsigned int)curves::resident_samples(curve),
+            curves::evaluate_job
+        });
+    }
+
+    if (jobs.empty()) {
+        return;
+    }
+
+    reserve_buffer(job_buffer, job_buffer_bytes, jobs.size() * sizeof(curves::TessellationJob), false);
+    glNamedBufferSubData(job_buffer, 0, jobs.size() * sizeof(curves::TessellationJob), jobs.data());
+    curves::count_uploaded_bytes(jobs.size() * sizeof(curves::TessellationJob));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curves::sample_block_binding, sample_vbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curves::control_point_block_binding, point_pool);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curves::tessellation_job_block_binding, job_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curves::previous_sample_block_binding, previous_samples);
+
+    program.use();
+    program.setInt(num_jobs_location, jobs.size());
+    glDispatchCompute(std::min((unsigned int)jobs.size(), max_work_groups), 1, 1);
+
+    // The samples are read as vertices, as a storage block by the wide
+    // lines, and copied by the next layout change
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void GpuTessellator::invalidate()
+{
+    for (int c : resident_curves) {
+        if (c < (int)resident.size()) {
+            resident[c] = false;
+        }
+    }
+    resident_curves.clear();
+    num_resident_samples = 0;
+}
+
+void GpuTessellator::uploadControlPoints()
+{
+    reserve_buffer(point_pool, point_pool_bytes, control_vertices.size() * sizeof(glm::vec4), true);
+
+    // One upload per run of curves whose vertices are adjacent
+    std::size_t i = 0;
+    while (i < evaluated_curves.size()) {
+        int first_vertex = scene_curves[evaluated_curves[i]].first_vertex;
+        staged_points.clear();
+
+        int end_vertex = first_vertex;
+        while (i < evaluated_curves.size() && scene_curves[evaluated_curves[i]].first_vertex == end_vertex) {
+            const Curve& curve = scene_curves[evaluated_curves[i]];
+            glm::dvec2 origin(curve.sample_origin);
+            for (int v = curve.first_vertex; v < curve.first_vertex + curve.num_vertices; ++v) {
+                const Vertex& vertex = control_vertices[v];
+                glm::vec2 position(glm::dvec2(vertex.position) - origin);
+                staged_points.push_back(glm::vec4(position.x, position.y, vertex.weight, 0.0f));
+            }
+            end_vertex += curve.num_vertices;
+            i++;
+        }
+
+        glNamedBufferSubData(
+            point_pool, first_vertex * sizeof(glm::vec4), staged_points.size() * sizeof(glm::vec4), staged_points.data()
+        );
+        curves::count_uploaded_bytes(staged_points.size() * sizeof(glm::vec4));
+    }
+}
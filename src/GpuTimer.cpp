@@ -0,0 +1,66 @@
+#include "2dcurves/GpuTimer.h"
+
+#include <glad/gl.h>
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(num_queries, queries);
+}
+
+void GpuTimer::begin()
+{
+    collect();
+
+    // Skip this interval if every query is still in flight
+    measuring = num_pending < num_queries;
+    if (measuring) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[(first_pending + num_pending) % num_queries]);
+    }
+}
+
+void GpuTimer::end()
+{
+    if (measuring) {
+        glEndQuery(GL_TIME_ELAPSED);
+        num_pending++;
+        measuring = false;
+    }
+}
+
+double GpuTimer::takeAverageMilliseconds()
+{
+    collect();
+
+    if (num_results == 0) {
+        return -1.0;
+    }
+
+    double res = total_milliseconds / num_results;
+    total_milliseconds = 0.0;
+    num_results = 0;
+
+    return res;
+}
+
+void GpuTimer::collect()
+{
+    // Queries complete in order
+    while (num_pending > 0) {
+        unsigned int query = queries[first_pending];
+
+        int available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        last_milliseconds = nanoseconds * 1e-6;
+        total_milliseconds += last_milliseconds;
+        num_results++;
+
+        first_pending = (first_pending + 1) % num_queries;
+        num_pending--;
+    }
+}
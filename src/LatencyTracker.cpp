@@ -0,0 +1,92 @@
+#include "2dcurves/LatencyTracker.h"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+LatencyTracker::LatencyTracker()
+{
+    glGenQueries(num_queries, queries);
+    calibrate();
+}
+
+void LatencyTracker::inputArrived(double time)
+{
+    if (pending_input_time < 0.0 || time < pending_input_time) {
+        pending_input_time = time;
+    }
+}
+
+void LatencyTracker::framePresented()
+{
+    collect();
+
+    // Frames without input have nothing to measure, and inputs are
+    // dropped if every query is still in flight
+    if (pending_input_time < 0.0 || num_pending == num_queries) {
+        pending_input_time = -1.0;
+        return;
+    }
+
+    int slot = (first_pending + num_pending) % num_queries;
+    glQueryCounter(queries[slot], GL_TIMESTAMP);
+    input_times[slot] = pending_input_time;
+    num_pending++;
+
+    pending_input_time = -1.0;
+}
+
+bool LatencyTracker::takeMilliseconds(double& average, double& maximum)
+{
+    collect();
+
+    // The two clocks drift apart slowly, re-align them between reports
+    calibrate();
+
+    if (num_results == 0) {
+        return false;
+    }
+
+    average = total_milliseconds / num_results;
+    maximum = max_milliseconds;
+
+    total_milliseconds = 0.0;
+    max_milliseconds = 0.0;
+    num_results = 0;
+
+    return true;
+}
+
+void LatencyTracker::calibrate()
+{
+    GLint64 gpu_nanoseconds = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_nanoseconds);
+    clock_offset = glfwGetTime() - gpu_nanoseconds * 1e-9;
+}
+
+void LatencyTracker::collect()
+{
+    // Queries complete in order
+    while (num_pending > 0) {
+        unsigned int query = queries[first_pending];
+
+        int available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+
+        GLuint64 gpu_nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_nanoseconds);
+
+        double presented = gpu_nanoseconds * 1e-9 + clock_offset;
+        double milliseconds = (presented - input_times[first_pending]) * 1e3;
+        total_milliseconds += milliseconds;
+        max_milliseconds = std::max(max_milliseconds, milliseconds);
+        num_results++;
+
+        first_pending = (first_pending + 1) % num_queries;
+        num_pending--;
+    }
+}
@@ -0,0 +1,298 @@
+#include "2dcurves/RenderThread.h"
+
+#include <glad/gl.h>
+
+#include <iostream>
+#include <utility>
+
+namespace {
+    // Vertex buffer binding points of the VAOs
+    constexpr unsigned int position_binding = 0;
+    constexpr unsigned int draw_id_binding = 1;
+
+    // Positions from vbo, or none if 0, and one curve id per instance
+    unsigned int create_vao(unsigned int vbo, unsigned int draw_id_vbo)
+    {
+        unsigned int vao;
+        glCreateVertexArrays(1, &vao);
+
+        if (vbo != 0) {
+            glEnableVertexArrayAttrib(vao, 0);
+            glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+            glVertexArrayAttribBinding(vao, 0, position_binding);
+            glVertexArrayVertexBuffer(vao, position_binding, vbo, 0, sizeof(glm::vec2));
+        }
+
+        glEnableVertexArrayAttrib(vao, curves::draw_id_attribute);
+        glVertexArrayAttribIFormat(vao, curves::draw_id_attribute, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(vao, curves::draw_id_attribute, draw_id_binding);
+        glVertexArrayVertexBuffer(vao, draw_id_binding, draw_id_vbo, 0, sizeof(unsigned int));
+        glVertexArrayBindingDivisor(vao, draw_id_binding, 1);
+
+        return vao;
+    }
+}
+
+RenderThread::RenderThread(
+    Shader& curve_program,
+    Shader& wide_line_program,
+    unsigned int frame_ubo,
+    unsigned int curve_ssbo,
+    unsigned int draw_id_vbo)
+    : curve_program(curve_program),
+      wide_line_program(wide_line_program),
+      frame_ubo(frame_ubo),
+      curve_ssbo(curve_ssbo),
+      draw_id_vbo(draw_id_vbo),
+      stats_hud(curve_program)
+{
+    highlight_mode_location = curve_program.getUniformLocation("highlight_mode");
+
+    glCreateBuffers(1, &sample_vbo);
+    glCreateBuffers(1, &control_point_vbo);
+    sample_vao = create_vao(sample_vbo, draw_id_vbo);
+    control_point_vao = create_vao(control_point_vbo, draw_id_vbo);
+    wide_line_vao = create_vao(0, draw_id_vbo);
+}
+
+RenderThread::~RenderThread()
+{
+    if (running()) {
+        stop();
+    }
+
+    unsigned int vaos[] = {sample_vao, control_point_vao, wide_line_vao};
+    glDeleteVertexArrays(3, vaos);
+    unsigned int buffers[] = {sample_vbo, control_point_vbo};
+    glDeleteBuffers(2, buffers);
+}
+
+void RenderThread::start(GLFWwindow* window)
+{
+    this->window = window;
+    last_report_time = glfwGetTime();
+    thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+{
+    mailbox.close();
+    thread.join();
+
+    // The next start uploads all samples again
+    mailbox.reset();
+    drawn.reset();
+}
+
+std::shared_ptr<const FrameSnapshot> RenderThread::publish(std::shared_ptr<const FrameSnapshot> snapshot)
+{
+    return mailbox.publish(std::move(snapshot));
+}
+
+void RenderThread::run()
+{
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(1);
+
+    while (mailbox.wait()) {
+        std::shared_ptr<const FrameSnapshot> snapshot = mailbox.take();
+
+        if (snapshot->input_time >= 0.0) {
+            input_latency.inputArrived(snapshot->input_time);
+        }
+        if (snapshot->cursor_time >= 0.0) {
+            cursor_latency.inputArrived(snapshot->cursor_time);
+        }
+
+        draw(*snapshot);
+
+        glfwSwapBuffers(window);
+        input_latency.framePresented();
+        cursor_latency.framePresented();
+
+        if (snapshot->report_frame_times && glfwGetTime() - last_report_time > 2.0) {
+            report(*snapshot);
+            last_report_time = glfwGetTime();
+        }
+
+        drawn = std::move(snapshot);
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
+
+void RenderThread::draw(const FrameSnapshot& snapshot)
+{
+    double start_time = glfwGetTime();
+
+    glViewport(0, 0, (int)snapshot.frame.viewport_size.x, (int)snapshot.frame.viewport_size.y);
+    glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    curves::upload_frame_data(frame_ubo, snapshot.frame);
+    uploadSamples(snapshot);
+    curves::upload_curve_records(curve_ssbo, draw_id_vbo, snapshot.records);
+
+    curve_pass_timer.begin();
+    if (snapshot.lines == line_style::wide) {
+        wide_line_program.use();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Each segment is expanded to a quad of two triangles, the vertex
+        // shader reads the samples from a storage block
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curves::sample_block_binding, sample_vbo);
+        glBindVertexArray(wide_line_vao);
+        int offset = 0;
+        for (std::size_t k = 0; k < snapshot.visible_curves.size(); ++k) {
+            if (sample_counts[k] >= 2) {
+                glDrawArraysInstancedBaseInstance(
+                    GL_TRIANGLES, 6 * offset, 6 * (sample_counts[k] - 1), 1, snapshot.visible_curves[k]
+                );
+            }
+            offset += sample_counts[k];
+        }
+        glBindVertexArray(0);
+
+        glDisable(GL_BLEND);
+    } else if (snapshot.lines == line_style::batched_strip) {
+        curve_program.use();
+        strip_batch.update(sample_vbo, snapshot.visible_curves, sample_counts);
+        strip_batch.draw();
+    } else {
+        curve_program.use();
+        glBindVertexArray(sample_vao);
+        int offset = 0;
+        for (std::size_t k = 0; k < snapshot.visible_curves.size(); ++k) {
+            if (sample_counts[k] > 0) {
+                glDrawArraysInstancedBaseInstance(GL_LINE_STRIP, offset, sample_counts[k], 1, snapshot.visible_curves[k]);
+            }
+            offset += sample_counts[k];
+        }
+        glBindVertexArray(0);
+    }
+    curve_pass_timer.end();
+
+    curve_program.use();
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
+    if (!snapshot.control_points.empty()) {
+        glNamedBufferData(
+            control_point_vbo,
+            snapshot.control_points.size() * sizeof(glm::vec2),
+            snapshot.control_points.data(),
+            GL_STREAM_DRAW
+        );
+        curves::count_uploaded_bytes(snapshot.control_points.size() * sizeof(glm::vec2));
+
+        glBindVertexArray(control_point_vao);
+        for (const FrameSnapshot::VertexRange& polygon : snapshot.control_polygons) {
+            glDrawArraysInstancedBaseInstance(GL_POINTS, polygon.first, polygon.count, 1, polygon.curve);
+            glDrawArraysInstancedBaseInstance(GL_LINE_STRIP, polygon.first, polygon.count, 1, polygon.curve);
+        }
+
+        if (!snapshot.selected_vertices.empty()) {
+            curve_program.setInt(highlight_mode_location, 1);
+            for (const FrameSnapshot::VertexRange& run : snapshot.selected_vertices) {
+                glDrawArraysInstancedBaseInstance(GL_POINTS, run.first, run.count, 1, run.curve);
+            }
+        }
+        glBindVertexArray(0);
+    }
+
+    if (!snapshot.outline.empty()) {
+        glNamedBufferData(
+            control_point_vbo,
+            snapshot.outline.size() * sizeof(glm::vec2),
+            snapshot.outline.data(),
+            GL_STREAM_DRAW
+        );
+        curves::count_uploaded_bytes(snapshot.outline.size() * sizeof(glm::vec2));
+
+        curve_program.setInt(highlight_mode_location, 2);
+        glBindVertexArray(control_point_vao);
+        glDrawArrays(GL_LINE_LOOP, 0, snapshot.outline.size());
+        glBindVertexArray(0);
+    }
+    curve_program.setInt(highlight_mode_location, 0);
+
+    // The HUD leaves itself out of what it shows
+    std::size_t upload_bytes = curves::take_uploaded_bytes();
+    if (snapshot.show_stats) {
+        StatsHud::Sample sample{};
+        sample.curves = snapshot.visible_curves.size();
+        for (int num_samples : sample_counts) {
+            sample.samples += num_samples;
+        }
+        sample.upload_bytes = upload_bytes;
+        sample.cpu_milliseconds = snapshot.update_milliseconds + (glfwGetTime() - start_time) * 1e3;
+        sample.gpu_milliseconds = curve_pass_timer.lastMilliseconds();
+
+        stats_hud.record(sample);
+        stats_hud.draw();
+    }
+}
+
+void RenderThread::uploadSamples(const FrameSnapshot& snapshot)
+{
+    sample_counts.clear();
+    for (const auto& samples : snapshot.samples) {
+        sample_counts.push_back(samples->size());
+    }
+
+    // With the same curves and as many samples each as the buffer holds,
+    // only the arrays replaced since the last snapshot are uploaded
+    bool same_layout = drawn && drawn->visible_curves == snapshot.visible_curves;
+    for (std::size_t k = 0; same_layout && k < sample_counts.size(); ++k) {
+        same_layout = (int)drawn->samples[k]->size() == sample_counts[k];
+    }
+
+    if (same_layout) {
+        int offset = 0;
+        for (std::size_t k = 0; k < sample_counts.size(); ++k) {
+            if (snapshot.samples[k] != drawn->samples[k]) {
+                glNamedBufferSubData(
+                    sample_vbo, offset * sizeof(glm::vec2), sample_counts[k] * sizeof(glm::vec2), snapshot.samples[k]->data()
+                );
+                curves::count_uploaded_bytes(sample_counts[k] * sizeof(glm::vec2));
+            }
+            offset += sample_counts[k];
+        }
+        return;
+    }
+
+    staged_samples.clear();
+    for (const auto& samples : snapshot.samples) {
+        staged_samples.insert(staged_samples.end(), samples->begin(), samples->end());
+    }
+
+    // A storage block must not be bound to an empty buffer
+    if (staged_samples.empty()) {
+        staged_samples.push_back(glm::vec2(0.0f));
+    }
+
+    glNamedBufferData(sample_vbo, staged_samples.size() * sizeof(glm::vec2), staged_samples.data(), GL_DYNAMIC_DRAW);
+    curves::count_uploaded_bytes(staged_samples.size() * sizeof(glm::vec2));
+}
+
+void RenderThread::report(const FrameSnapshot& snapshot)
+{
+    double milliseconds = curve_pass_timer.takeAverageMilliseconds();
+    if (milliseconds >= 0.0) {
+        const char* style = "line strips";
+        if (snapshot.lines == line_style::batched_strip) {
+            style = "batched line strips";
+        } else if (snapshot.lines == line_style::wide) {
+            style = "wide lines";
+        }
+        std::cout << "Curve pass: " << milliseconds << " ms GPU (" << style << ", render thread)" << std::endl;
+    }
+
+    double average, maximum;
+    if (input_latency.takeMilliseconds(average, maximum)) {
+        std::cout << "Input to present: " << average << " ms average, " << maximum << " ms max" << std::endl;
+    }
+    if (cursor_latency.takeMilliseconds(average, maximum)) {
+        std::cout << "Cursor sample to present: " << average << " ms average, " << maximum << " ms max" << std::endl;
+    }
+}
@@ -1,99 +1,138 @@
 #include "2dcurves/Shader.h"
 
 #include <glad/gl.h>
+#include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
-{
-    // Retrieve source code from filepath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    // Ensure ifstream objects can throw exceptions
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try
+namespace {
+    std::string read_shader_file(const char* path)
     {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-
-        // read files' buffer contents into streams
-        std::stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        std::ifstream file;
+
+        // Ensure ifstream objects can throw exceptions
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            return stream.str();
+        }
+        catch(const std::ifstream::failure&)
+        {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+            return std::string();
+        }
     }
-    catch(std::ifstream::failure e)
+
+    // stage names the shader in error messages
+    unsigned int compile_shader(GLenum type, const char* path, const char* stage)
     {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        std::string code = read_shader_file(path);
+        const char* source = code.c_str();
+
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+
+        // print compile errors if any
+        int success;
+        char infoLog[512];
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" <<
+                infoLog << std::endl;
+        }
+
+        return shader;
     }
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    // compile shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
-
-    // vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-
-    // print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" <<
-            infoLog << std::endl;
+    void link_program(unsigned int program)
+    {
+        glLinkProgram(program);
+
+        // print linking errors if any
+        int success;
+        char infoLog[512];
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" <<
+                infoLog << std::endl;
+        }
     }
+}
 
-    // fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-
-    // print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" <<
-            infoLog << std::endl;
-    }
+Shader::Shader(const char* vertexPath, const char* fragmentPath)
+{
+    unsigned int vertex = compile_shader(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+    unsigned int fragment = compile_shader(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
 
     // shader program
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-
-    // print linking errors if any
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" <<
-            infoLog << std::endl;
-    }
+    link_program(ID);
 
     // delete shaders
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    cacheUniformLocations();
+}
+
+Shader::Shader(const char* computePath)
+{
+    unsigned int compute = compile_shader(GL_COMPUTE_SHADER, computePath, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute);
+    link_program(ID);
+    glDeleteShader(compute);
+
+    cacheUniformLocations();
+}
+
+void Shader::cacheUniformLocations()
+{
+    uniformLocations.clear();
+
+    int numUniforms = 0;
+    int maxNameLength = 0;
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    std::vector<char> name(maxNameLength + 1);
+    const GLenum props[] = {GL_LOCATION};
+
+    for (int i = 0; i < numUniforms; ++i) {
+        int location = -1;
+        glGetProgramResourceiv(ID, GL_UNIFORM, i, 1, props, 1, NULL, &location);
+
+        // uniform block members have no location of their own
+        if (location < 0) {
+            continue;
+        }
+
+        int length = 0;
+        glGetProgramResourceName(ID, GL_UNIFORM, i, name.size(), &length, name.data());
+        std::string uniformName(name.data(), length);
+        uniformLocations[uniformName] = location;
+
+        // arrays are reported as "name[0]", also register them as "name"
+        if (uniformName.ends_with("[0]")) {
+            uniformName.resize(uniformName.size() - 3);
+            uniformLocations[uniformName] = location;
+        }
+    }
 }
 
 void Shader::use()
@@ -101,17 +140,47 @@ void Shader::use()
     glUseProgram(ID);
 }
 
-void Shader::setBool(const std::string &name, bool value) const
+int Shader::getUniformLocation(const std::string &name) const
+{
+    auto it = uniformLocations.find(name);
+    if (it == uniformLocations.end()) {
+        return -1;
+    }
+
+    return it->second;
+}
+
+void Shader::setBool(int location, bool value) const
+{
+    glUniform1i(location, (int)value);
+}
+
+void Shader::setInt(int location, int value) const
+{
+    glUniform1i(location, value);
+}
+
+void Shader::setFloat(int location, float value) const
+{
+    glUniform1f(location, value);
+}
+
+void Shader::setVec2(int location, const glm::vec2 &value) const
+{
+    glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setVec4(int location, const glm::vec4 &value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform4fv(location, 1, glm::value_ptr(value));
 }
 
-void Shader::setInt(const std::string &name, int value) const
+void Shader::setMat3(int location, const glm::mat3 &value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void Shader::setFloat(const std::string &name, float value) const
+void Shader::setMat4(int location, const glm::mat4 &value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "2dcurves/SnapshotMailbox.h"
+
+#include <utility>
+
+std::shared_ptr<const FrameSnapshot> SnapshotMailbox::publish(std::shared_ptr<const FrameSnapshot> snapshot)
+{
+    slots[back] = std::move(snapshot);
+    unsigned int previous = latest.exchange(back | fresh_bit, std::memory_order_acq_rel);
+    latest.notify_one();
+
+    // The reader leaves the slots it took from empty
+    back = previous & index_mask;
+    return std::move(slots[back]);
+}
+
+std::shared_ptr<const FrameSnapshot> SnapshotMailbox::take()
+{
+    // Only the reader clears fresh_bit, it cannot go away before the
+    // exchange
+    if ((latest.load(std::memory_order_relaxed) & fresh_bit) == 0) {
+        return nullptr;
+    }
+
+    front = latest.exchange(front, std::memory_order_acq_rel) & index_mask;
+    return std::move(slots[front]);
+}
+
+bool SnapshotMailbox::wait()
+{
+    unsigned int value = latest.load(std::memory_order_acquire);
+    while ((value & fresh_bit) == 0) {
+        if (closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        // close() changes the value after setting closed, so it cannot
+        // slip in between the check and the wait
+        latest.wait(value, std::memory_order_acquire);
+        value = latest.load(std::memory_order_acquire);
+    }
+
+    return true;
+}
+
+void SnapshotMailbox::close()
+{
+    closed.store(true, std::memory_order_release);
+    latest.fetch_xor(wake_bit, std::memory_order_acq_rel);
+    latest.notify_all();
+}
+
+void SnapshotMailbox::reset()
+{
+    for (auto& slot : slots) {
+        slot.reset();
+    }
+
+    latest.store(1);
+    closed.store(false);
+    back = 0;
+    front = 2;
+}
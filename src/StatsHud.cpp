@@ -0,0 +1,195 @@
+#include "2dcurves/StatsHud.h"
+
+#include <glad/gl.h>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // Layout in pixels
+    constexpr float margin = 10.0f;
+    constexpr float row_height = 26.0f;
+    constexpr float bar_width = 2.0f;
+    constexpr float graph_height = 20.0f;
+    constexpr float digit_width = 10.0f;
+    constexpr float digit_height = 18.0f;
+    constexpr float stroke = 2.0f;
+    constexpr float digit_advance = 14.0f;
+    constexpr float point_advance = 6.0f;
+
+    // Segments a to g, clockwise from the top and then the middle one, bit
+    // k for segment k
+    constexpr unsigned char digit_segments[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+    constexpr unsigned char minus_segments = 0x40;
+
+    const glm::vec4 background_color(0.0f, 0.0f, 0.0f, 0.6f);
+    const glm::vec4 row_colors[] = {
+        glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+        glm::vec4(0.4f, 0.8f, 1.0f, 1.0f),
+        glm::vec4(1.0f, 0.8f, 0.2f, 1.0f),
+        glm::vec4(0.4f, 1.0f, 0.4f, 1.0f),
+        glm::vec4(1.0f, 0.4f, 0.8f, 1.0f)
+    };
+
+    const char* row_formats[] = {"%.0f", "%.0f", "%.1f", "%.2f", "%.2f"};
+
+    void add_rect(std::vector<glm::vec2>& vertices, float x, float y, float width, float height)
+    {
+        glm::vec2 a(x, y);
+        glm::vec2 b(x + width, y);
+        glm::vec2 c(x + width, y + height);
+        glm::vec2 d(x, y + height);
+        vertices.insert(vertices.end(), {a, b, c, a, c, d});
+    }
+
+    void add_segments(std::vector<glm::vec2>& vertices, float x, float y, unsigned char segments)
+    {
+        // x, y, width and height of each segment from the bottom left
+        // corner of the digit
+        constexpr float half = 0.5f * digit_height;
+        constexpr float right = digit_width - stroke;
+        constexpr float rects[7][4] = {
+            {0.0f, digit_height - stroke, digit_width, stroke},
+            {right, half, stroke, half},
+            {right, 0.0f, stroke, half},
+            {0.0f, 0.0f, digit_width, stroke},
+            {0.0f, 0.0f, stroke, half},
+            {0.0f, half, stroke, half},
+            {0.0f, half - 0.5f * stroke, digit_width, stroke}
+        };
+
+        for (int k = 0; k < 7; ++k) {
+            if (segments & (1u << k)) {
+                add_rect(vertices, x + rects[k][0], y + rects[k][1], rects[k][2], rects[k][3]);
+            }
+        }
+    }
+}
+
+StatsHud::StatsHud(Shader& program)
+    : program(program)
+{
+    highlight_mode_location = program.getUniformLocation("highlight_mode");
+    hud_color_location = program.getUniformLocation("hud_color");
+
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, max_vertices * sizeof(glm::vec2), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateVertexArrays(1, &vao);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(glm::vec2));
+
+    vertices.reserve(max_vertices);
+}
+
+StatsHud::~StatsHud()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+}
+
+void StatsHud::record(const Sample& sample)
+{
+    int last = (first + count + history_size - 1) % history_size;
+    float gpu_milliseconds = sample.gpu_milliseconds;
+    if (gpu_milliseconds < 0.0) {
+        gpu_milliseconds = count > 0 ? history[last][4] : 0.0f;
+    }
+
+    int slot = (first + count) % history_size;
+    history[slot] = {
+        (float)sample.curves,
+        (float)sample.samples,
+        (float)(sample.upload_bytes / 1024.0),
+        (float)sample.cpu_milliseconds,
+        gpu_milliseconds
+    };
+
+    if (count < history_size) {
+        count++;
+    } else {
+        first = (first + 1) % history_size;
+    }
+}
+
+void StatsHud::draw()
+{
+    if (count == 0) {
+        return;
+    }
+
+    vertices.clear();
+    float panel_width = history_size * bar_width + margin + max_characters * digit_advance;
+    add_rect(vertices, 0.0f, 0.0f, 2.0f * margin + panel_width, 2.0f * margin + num_statistics * row_height);
+
+    for (int row = 0; row < num_statistics; ++row) {
+        row_starts[row] = vertices.size();
+        addRow(row);
+    }
+    row_starts[num_statistics] = vertices.size();
+
+    glNamedBufferSubData(vbo, 0, vertices.size() * sizeof(glm::vec2), vertices.data());
+
+    program.use();
+    program.setInt(highlight_mode_location, 3);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(vao);
+
+    program.setVec4(hud_color_location, background_color);
+    glDrawArrays(GL_TRIANGLES, 0, row_starts[0]);
+
+    for (int row = 0; row < num_statistics; ++row) {
+        program.setVec4(hud_color_location, row_colors[row]);
+        glDrawArrays(GL_TRIANGLES, row_starts[row], row_starts[row + 1] - row_starts[row]);
+    }
+
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    program.setInt(highlight_mode_location, 0);
+}
+
+void StatsHud::addRow(int row)
+{
+    // Rows from the top, the panel sits in the bottom left corner
+    float y = margin + (num_statistics - 1 - row) * row_height;
+
+    float maximum = 0.0f;
+    for (int k = 0; k < count; ++k) {
+        maximum = std::max(maximum, history[(first + k) % history_size][row]);
+    }
+
+    // Oldest on the left, bars of the newest samples end at the digits
+    if (maximum > 0.0f) {
+        float x = margin + (history_size - count) * bar_width;
+        for (int k = 0; k < count; ++k) {
+            float value = history[(first + k) % history_size][row];
+            if (value > 0.0f) {
+                add_rect(vertices, x, y, bar_width, std::max(1.0f, value / maximum * graph_height));
+            }
+            x += bar_width;
+        }
+    }
+
+    char text[32];
+    float latest = history[(first + count - 1) % history_size][row];
+    std::snprintf(text, sizeof(text), row_formats[row], latest);
+
+    float x = 2.0f * margin + history_size * bar_width;
+    for (int i = 0; i < max_characters && text[i] != '\0'; ++i) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            add_segments(vertices, x, y, digit_segments[c - '0']);
+            x += digit_advance;
+        } else if (c == '-') {
+            add_segments(vertices, x, y, minus_segments);
+            x += digit_advance;
+        } else if (c == '.') {
+            add_rect(vertices, x - 0.5f * stroke, y, stroke, stroke);
+            x += point_advance;
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include "2dcurves/StripBatch.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/shader_data.h"
+#include "2dcurves/tessellation.h"
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+namespace {
+    // Vertex buffer binding points of the VAO
+    constexpr unsigned int sample_binding = 0;
+    constexpr unsigned int curve_id_binding = 1;
+}
+
+StripBatch::StripBatch()
+{
+    glCreateVertexArrays(1, &vao);
+    glCreateBuffers(1, &index_buffer);
+    glCreateBuffers(1, &curve_id_buffer);
+
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, sample_binding);
+
+    // Same attribute as the instanced draw id of the per-curve draws, but
+    // per vertex
+    glEnableVertexArrayAttrib(vao, curves::draw_id_attribute);
+    glVertexArrayAttribIFormat(vao, curves::draw_id_attribute, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vao, curves::draw_id_attribute, curve_id_binding);
+    glVertexArrayVertexBuffer(vao, curve_id_binding, curve_id_buffer, 0, sizeof(unsigned int));
+
+    glVertexArrayElementBuffer(vao, index_buffer);
+}
+
+StripBatch::~StripBatch()
+{
+    glDeleteVertexArrays(1, &vao);
+    unsigned int buffers[] = {index_buffer, curve_id_buffer};
+    glDeleteBuffers(2, buffers);
+}
+
+void StripBatch::update(unsigned int sample_vbo, const std::vector<int>& visible_curves)
+{
+    // The tessellation lays the curves out back to back
+    resident_counts.clear();
+    for (int c : visible_curves) {
+        resident_counts.push_back(curves::resident_samples(scene_curves[c]));
+    }
+
+    update(sample_vbo, visible_curves, resident_counts);
+}
+
+void StripBatch::update(unsigned int sample_vbo, const std::vector<int>& visible_curves, const std::vector<int>& sample_counts)
+{
+    // The tessellation may re-specify the store, but keeps the name
+    if (sample_vbo != bound_sample_vbo) {
+        glVertexArrayVertexBuffer(vao, sample_binding, sample_vbo, 0, sizeof(glm::vec2));
+        bound_sample_vbo = sample_vbo;
+    }
+
+    if (visible_curves != batched_curves || sample_counts != batched_samples) {
+        rebuild(visible_curves, sample_counts);
+    }
+}
+
+void StripBatch::draw() const
+{
+    if (num_indices == 0) {
+        return;
+    }
+
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(restart_index);
+
+    glBindVertexArray(vao);
+    glDrawElements(GL_LINE_STRIP, num_indices, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+
+    glDisable(GL_PRIMITIVE_RESTART);
+}
+
+void StripBatch::rebuild(const std::vector<int>& visible_curves, const std::vector<int>& sample_counts)
+{
+    batched_curves = visible_curves;
+    batched_samples = sample_counts;
+
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> curve_ids;
+
+    int sample_offset = 0;
+    for (std::size_t k = 0; k < visible_curves.size(); ++k) {
+        int num_samples = sample_counts[k];
+        if (num_samples == 0) {
+            continue;
+        }
+
+        if (!indices.empty()) {
+            indices.push_back(restart_index);
+        }
+        for (int j = 0; j < num_samples; ++j) {
+            indices.push_back(sample_offset + j);
+        }
+
+        // Indexed by sample, like the positions
+        curve_ids.insert(curve_ids.end(), num_samples, visible_curves[k]);
+        sample_offset += num_samples;
+    }
+
+    num_indices = indices.size();
+    num_rebuilds++;
+    if (indices.empty()) {
+        return;
+    }
+
+    glNamedBufferData(index_buffer, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glNamedBufferData(curve_id_buffer, curve_ids.size() * sizeof(unsigned int), curve_ids.data(), GL_STATIC_DRAW);
+    curves::count_uploaded_bytes((indices.size() + curve_ids.size()) * sizeof(unsigned int));
+}
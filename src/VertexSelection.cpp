@@ -0,0 +1,42 @@
+#include "2dcurves/VertexSelection.h"
+
+#include <algorithm>
+
+void VertexSelection::resize(int num_vertices)
+{
+    this->num_vertices = num_vertices;
+    words.resize((num_vertices + 63) / 64, 0);
+
+    // Bits past the end stay clear, iteration relies on it
+    if (num_vertices % 64 != 0) {
+        words.back() &= (std::uint64_t(1) << (num_vertices % 64)) - 1;
+    }
+}
+
+void VertexSelection::clear()
+{
+    std::fill(words.begin(), words.end(), 0);
+}
+
+void VertexSelection::unite(const VertexSelection& other)
+{
+    std::size_t common = std::min(words.size(), other.words.size());
+    for (std::size_t w = 0; w < common; ++w) {
+        words[w] |= other.words[w];
+    }
+    resize(num_vertices);
+}
+
+int VertexSelection::count() const
+{
+    int res = 0;
+    for (std::uint64_t word : words) {
+        res += std::popcount(word);
+    }
+    return res;
+}
+
+bool VertexSelection::empty() const
+{
+    return std::all_of(words.begin(), words.end(), [](std::uint64_t word) { return word == 0; });
+}
@@ -0,0 +1,76 @@
+#include "2dcurves/arc_length.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/tessellation.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace curves{
+
+    const std::vector<float>& arc_length_table(Curve& curve)
+    {
+        assert(curve.num_vertices > 0);
+
+        if (curve.arc_lengths_revision == curve.revision) {
+            return curve.arc_lengths;
+        }
+
+        // Chord lengths of a dense uniform tessellation
+        std::vector<glm::vec2> points(arc_length_table_size);
+        evaluate_curve(curve, arc_length_table_size, points.data());
+
+        curve.arc_lengths.resize(arc_length_table_size);
+        curve.arc_lengths[0] = 0.0f;
+        for (int j = 1; j < arc_length_table_size; ++j) {
+            curve.arc_lengths[j] = curve.arc_lengths[j - 1] + glm::distance(points[j - 1], points[j]);
+        }
+
+        curve.arc_lengths_revision = curve.revision;
+        return curve.arc_lengths;
+    }
+
+    float curve_length(Curve& curve)
+    {
+        return arc_length_table(curve).back();
+    }
+
+    float parameter_at_length(const std::vector<float>& arc_lengths, float length)
+    {
+        int last = arc_lengths.size() - 1;
+        if (length <= 0.0f) {
+            return 0.0f;
+        }
+        if (length >= arc_lengths[last]) {
+            return 1.0f;
+        }
+
+        // First entry past length, then interpolate linearly within the interval
+        int j = std::upper_bound(arc_lengths.begin(), arc_lengths.end(), length) - arc_lengths.begin();
+        float interval = arc_lengths[j] - arc_lengths[j - 1];
+        float fraction = interval > 0.0f ? (length - arc_lengths[j - 1]) / interval : 0.0f;
+
+        return (j - 1 + fraction) / last;
+    }
+
+    glm::vec2 point_at_length(Curve& curve, float length)
+    {
+        float t = parameter_at_length(arc_length_table(curve), length);
+        return evaluate_curve_point(curve, t);
+    }
+
+    void evaluate_curve_by_arc_length(Curve& curve, int num_samples, glm::vec2* out)
+    {
+        assert(num_samples > 1);
+
+        const std::vector<float>& arc_lengths = arc_length_table(curve);
+        float step = arc_lengths.back() / (num_samples - 1);
+
+        for (int j = 0; j < num_samples; ++j) {
+            out[j] = evaluate_curve_point(curve, parameter_at_length(arc_lengths, j * step));
+        }
+    }
+}
@@ -0,0 +1,264 @@
+#include "2dcurves/bezier.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cassert>
+#include <vector>
+
+namespace curves{
+
+    glm::vec2 project(glm::vec3 point)
+    {
+        return glm::vec2(point.x, point.y) / point.z;
+    }
+
+    glm::vec3 lift(const Vertex& vertex)
+    {
+        return glm::vec3(vertex.weight * vertex.position, vertex.weight);
+    }
+
+    void split_bezier(const glm::vec3* points, int degree, float s, glm::vec3* left, glm::vec3* right)
+    {
+        assert(degree <= max_bezier_degree);
+
+        glm::vec3 work[max_bezier_degree + 1];
+        for (int i = 0; i <= degree; ++i) {
+            work[i] = points[i];
+        }
+
+        // Each level of the triangle gives one more point of each side
+        for (int r = 0; r <= degree; ++r) {
+            left[r] = work[0];
+            right[degree - r] = work[degree - r];
+            for (int i = 0; i < degree - r; ++i) {
+                work[i] = (1.0f - s) * work[i] + s * work[i + 1];
+            }
+        }
+    }
+
+    void elevate_bezier(const glm::vec3* points, int degree, glm::vec3* out)
+    {
+        assert(degree + 1 <= max_bezier_degree);
+        assert(out != points);
+
+        // out_i = i / (n + 1) p_(i-1) + (1 - i / (n + 1)) p_i
+        float inverse = 1.0f / (degree + 1);
+        out[0] = points[0];
+        for (int i = 1; i <= degree; ++i) {
+            float a = i * inverse;
+            out[i] = a * points[i - 1] + (1.0f - a) * points[i];
+        }
+        out[degree + 1] = points[degree];
+    }
+
+    void reduce_bezier(const glm::vec3* points, int degree, glm::vec3* out)
+    {
+        assert(degree >= 2 && degree <= max_bezier_degree);
+        assert(out != points);
+
+        // Elevating q_0, ..., q_m (m = n - 1) gives the points
+        // r_i = a_i q_(i-1) + b_i q_i with a_i = i / n and b_i = 1 - a_i. With
+        // q_0 = p_0 and q_m = p_n fixed, the normal equations of
+        // min sum |r_i - p_i|^2 are tridiagonal in q_1, ..., q_(m-1):
+        //   a_j b_j q_(j-1) + (b_j^2 + a_(j+1)^2) q_j + a_(j+1) b_(j+1) q_(j+1)
+        //     = b_j p_j + a_(j+1) p_(j+1)
+        // which the Thomas algorithm solves in O(n).
+        int n = degree;
+        int m = n - 1;
+        float inverse = 1.0f / n;
+
+        out[0] = points[0];
+        out[m] = points[n];
+
+        // Forward elimination, upper[j] and rhs[j] are the coefficients
+        // left after eliminating q_(j-1)
+        float upper[max_bezier_degree];
+        glm::vec3 rhs[max_bezier_degree];
+
+        for (int j = 1; j < m; ++j) {
+            float a_j = j * inverse;
+            float b_j = 1.0f - a_j;
+            float a_next = (j + 1) * inverse;
+            float b_next = 1.0f - a_next;
+
+            float lower = a_j * b_j;
+            float diagonal = b_j * b_j + a_next * a_next;
+            float above = a_next * b_next;
+            glm::vec3 value = b_j * points[j] + a_next * points[j + 1];
+
+            if (j == 1) {
+                value -= lower * out[0];
+            } else {
+                diagonal -= lower * upper[j - 1];
+                value -= lower * rhs[j - 1];
+            }
+            if (j == m - 1) {
+                value -= above * out[m];
+                above = 0.0f;
+            }
+
+            upper[j] = above / diagonal;
+            rhs[j] = value / diagonal;
+        }
+
+        // Back substitution
+        for (int j = m - 1; j >= 1; --j) {
+            out[j] = rhs[j] - upper[j] * out[j + 1];
+        }
+    }
+
+    void evaluate_bezier_derivatives(
+        const glm::vec3* points,
+        int degree,
+        float s,
+        glm::vec2& point,
+        glm::vec2& first_derivative,
+        glm::vec2& second_derivative
+    )
+    {
+        assert(degree <= max_bezier_degree);
+
+        glm::vec3 work[max_bezier_degree + 1];
+        for (int i = 0; i <= degree; ++i) {
+            work[i] = points[i];
+        }
+
+        // de Casteljau down to three points, keeping the last levels
+        glm::vec3 level2[3] = {work[0], work[0], work[0]};
+        glm::vec3 level1[2] = {work[0], work[0]};
+        for (int r = degree; r > 0; --r) {
+            if (r == 2) {
+                level2[0] = work[0];
+                level2[1] = work[1];
+                level2[2] = work[2];
+            }
+            if (r == 1) {
+                level1[0] = work[0];
+                level1[1] = work[1];
+            }
+            for (int i = 0; i < r; ++i) {
+                work[i] = (1.0f - s) * work[i] + s * work[i + 1];
+            }
+        }
+
+        // Derivatives of the homogeneous polynomial
+        glm::vec3 value = work[0];
+        glm::vec3 first(0.0f);
+        glm::vec3 second(0.0f);
+        if (degree >= 1) {
+            first = (float)degree * (level1[1] - level1[0]);
+        }
+        if (degree >= 2) {
+            second = (float)(degree * (degree - 1)) * (level2[2] - 2.0f * level2[1] + level2[0]);
+        }
+
+        // Quotient rule for C = A / w
+        glm::vec2 a(value.x, value.y);
+        glm::vec2 a1(first.x, first.y);
+        glm::vec2 a2(second.x, second.y);
+
+        point = a / value.z;
+        first_derivative = (a1 - first.z * point) / value.z;
+        second_derivative = (a2 - 2.0f * first.z * first_derivative - second.z * point) / value.z;
+    }
+
+    int bezier_pieces(const Curve& curve, std::vector<glm::vec3>& points, std::vector<float>& breaks)
+    {
+        return bezier_pieces(curve, control_vertices.data() + curve.first_vertex, points, breaks);
+    }
+
+    int bezier_pieces(
+        const Curve& curve,
+        const Vertex* vertices,
+        std::vector<glm::vec3>& points,
+        std::vector<float>& breaks
+    )
+    {
+        assert(curve.num_vertices > 0);
+
+        points.clear();
+        breaks.clear();
+
+        std::vector<glm::vec3> weighted(curve.num_vertices);
+        for (int i = 0; i < curve.num_vertices; ++i) {
+            weighted[i] = lift(vertices[i]);
+        }
+
+        int p = nurbs_degree(curve);
+        if (p == 0) {
+            points = weighted;
+            breaks = {0.0f, 1.0f};
+            return curve.num_vertices - 1;
+        }
+
+        // Knot insertion up to full multiplicity, algorithm A5.6 of The
+        // NURBS Book. Needs clamped knots and interior multiplicities of
+        // at most p, which nurbs_degree checks.
+        const std::vector<float>& knots = curve.knots;
+        int n = curve.num_vertices - 1;
+        int m = n + p + 1;
+        float u_first = knots[p];
+        float u_last = knots[n + 1];
+
+        std::vector<float> alphas(p);
+        std::vector<glm::vec3> piece(weighted.begin(), weighted.begin() + p + 1);
+        std::vector<glm::vec3> next_piece(p + 1);
+
+        breaks.push_back(0.0f);
+
+        int a = p;
+        int b = p + 1;
+        while (b < m) {
+            int i = b;
+            while (b < m && knots[b + 1] == knots[b]) {
+                b++;
+            }
+            int multiplicity = b - i + 1;
+
+            // Only the clamped end reaches p + 1, an interior knot that did
+            // would index next_piece[-1] below. nurbs_degree rejects those.
+            assert(multiplicity <= p || b == m);
+
+            if (multiplicity < p) {
+                float numerator = knots[b] - knots[a];
+                for (int j = p; j > multiplicity; --j) {
+                    alphas[j - multiplicity - 1] = numerator / (knots[a + j] - knots[a]);
+                }
+
+                int r = p - multiplicity;
+                for (int j = 1; j <= r; ++j) {
+                    int save = r - j;
+                    int s = multiplicity + j;
+                    for (int k = p; k >= s; --k) {
+                        float alpha = alphas[k - s];
+                        piece[k] = alpha * piece[k] + (1.0f - alpha) * piece[k - 1];
+                    }
+                    if (b < m) {
+                        next_piece[save] = piece[p];
+                    }
+                }
+            }
+
+            points.insert(points.end(), piece.begin(), piece.end());
+            breaks.push_back((knots[b] - u_first) / (u_last - u_first));
+
+            if (b < m) {
+                for (int k = p - multiplicity; k <= p; ++k) {
+                    next_piece[k] = weighted[b - p + k];
+                }
+                piece = next_piece;
+                a = b;
+                b++;
+            }
+        }
+
+        breaks.back() = 1.0f;
+        return p;
+    }
+}
@@ -0,0 +1,273 @@
+#include "2dcurves/chebyshev.h"
+
+#include <glm/vec2.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <numbers>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        // e^(2 pi i k / n) for k < n / 2, per transform size. Per thread
+        // like the work buffers, since they are filled on first use.
+        thread_local std::map<int, std::vector<std::complex<double>>> fft_twiddles;
+
+        // e^(i pi k / 2n) for k < n, per transform size
+        thread_local std::map<int, std::vector<std::complex<double>>> dct_rotations;
+
+        thread_local std::vector<std::complex<double>> fft_work_x, fft_work_y;
+        thread_local std::vector<double> node_cosines;
+        thread_local std::vector<glm::dvec2> node_values, clenshaw_b0, clenshaw_b1, clenshaw_b2;
+
+        // Curve at t in [0, 1] with the scaled Horner scheme,
+        // (1 - t)^n sum C(n, i) p_i (t / (1 - t))^i, from the end closer to
+        // t so that the ratio stays below 1. O(degree), binomials are
+        // carried along in double and stay finite up to
+        // max_chebyshev_degree.
+        glm::dvec2 evaluate_bernstein(const glm::dvec2* points, int degree, double t)
+        {
+            bool reversed = t > 0.5;
+            double s = reversed ? 1.0 - t : t;
+            double ratio = s / (1.0 - s);
+
+            auto point = [&](int i) {
+                return reversed ? points[degree - i] : points[i];
+            };
+
+            glm::dvec2 sum = point(degree);
+            double binomial = 1.0;
+            for (int i = degree - 1; i >= 0; --i) {
+                binomial = binomial * (i + 1) / (degree - i);
+                sum = sum * ratio + binomial * point(i);
+            }
+
+            return sum * std::pow(1.0 - s, degree);
+        }
+
+        // Product without the checks for infinities of std::complex, which
+        // would make the transforms several times slower
+        std::complex<double> multiply(std::complex<double> a, std::complex<double> b)
+        {
+            return std::complex<double>(
+                a.real() * b.real() - a.imag() * b.imag(),
+                a.real() * b.imag() + a.imag() * b.real()
+            );
+        }
+
+        // In-place inverse DFT without normalization,
+        // v_m = sum z_k e^(2 pi i k m / n), radix 2
+        void inverse_fft(std::vector<std::complex<double>>& z)
+        {
+            int n = z.size();
+
+            auto [it, inserted] = fft_twiddles.try_emplace(n);
+            std::vector<std::complex<double>>& twiddles = it->second;
+            if (inserted) {
+                twiddles.resize(n / 2);
+                for (int k = 0; k < n / 2; ++k) {
+                    twiddles[k] = std::polar(1.0, 2.0 * std::numbers::pi * k / n);
+                }
+            }
+
+            for (int i = 1, j = 0; i < n; ++i) {
+                int bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(z[i], z[j]);
+                }
+            }
+
+            for (int length = 2; length <= n; length <<= 1) {
+                int stride = n / length;
+                for (int start = 0; start < n; start += length) {
+                    for (int k = 0; k < length / 2; ++k) {
+                        std::complex<double> even = z[start + k];
+                        std::complex<double> odd = multiply(z[start + k + length / 2], twiddles[k * stride]);
+                        z[start + k] = even + odd;
+                        z[start + k + length / 2] = even - odd;
+                    }
+                }
+            }
+        }
+
+        // Bernstein coefficients of (2t - 1) p, one degree more than p
+        void multiply_by_x(const std::vector<glm::dvec2>& p, std::vector<glm::dvec2>& out)
+        {
+            int m = p.size() - 1;
+            out.resize(m + 2);
+
+            // t p_(i-1) shifts up, (1 - t) p_i stays, both rescaled
+            double inverse = 1.0 / (m + 1);
+            for (int i = 0; i <= m + 1; ++i) {
+                double a = i * inverse;
+                glm::dvec2 below = i > 0 ? p[i - 1] : glm::dvec2(0.0);
+                glm::dvec2 same = i <= m ? p[i] : glm::dvec2(0.0);
+                out[i] = a * below - (1.0 - a) * same;
+            }
+        }
+
+        // p elevated in place to the given degree, the zero polynomial if
+        // p is empty
+        void elevate_to(std::vector<glm::dvec2>& p, int degree)
+        {
+            if (p.empty()) {
+                p.assign(degree + 1, glm::dvec2(0.0));
+                return;
+            }
+
+            while ((int)p.size() <= degree) {
+                int m = p.size() - 1;
+                double inverse = 1.0 / (m + 1);
+                p.push_back(p[m]);
+                for (int i = m; i >= 1; --i) {
+                    double a = i * inverse;
+                    p[i] = a * p[i - 1] + (1.0 - a) * p[i];
+                }
+            }
+        }
+    }
+
+    void bernstein_to_chebyshev(const glm::dvec2* points, int degree, glm::dvec2* coefficients)
+    {
+        assert(degree >= 0 && degree <= max_chebyshev_degree);
+
+        // Values at the nodes cos(pi (2j + 1) / 2n) of [-1, 1], then their
+        // discrete cosine transform, which interpolates exactly
+        int n = degree + 1;
+        node_values.resize(n);
+        for (int j = 0; j < n; ++j) {
+            double x = std::cos(std::numbers::pi * (2 * j + 1) / (2.0 * n));
+            node_values[j] = evaluate_bernstein(points, degree, 0.5 * (x + 1.0));
+        }
+
+        // cos(pi k (2j + 1) / 2n) only takes 4n values
+        std::vector<double>& cosines = node_cosines;
+        cosines.resize(4 * n);
+        for (int i = 0; i < 4 * n; ++i) {
+            cosines[i] = std::cos(std::numbers::pi * i / (2.0 * n));
+        }
+
+        for (int k = 0; k < n; ++k) {
+            glm::dvec2 sum(0.0);
+            for (int j = 0; j < n; ++j) {
+                sum += cosines[k * (2 * j + 1) % (4 * n)] * node_values[j];
+            }
+            coefficients[k] = (k == 0 ? 1.0 : 2.0) / n * sum;
+        }
+    }
+
+    void chebyshev_to_bernstein(const glm::dvec2* coefficients, int degree, glm::dvec2* points)
+    {
+        assert(degree >= 0 && degree <= max_chebyshev_degree);
+
+        // b_k = c_k + 2x b_(k+1) - b_(k+2) from k = degree down to 1, and
+        // p = c_0 + x b_1 - b_2, where b_k has degree degree - k
+        std::vector<glm::dvec2>& b0 = clenshaw_b0;
+        std::vector<glm::dvec2>& b1 = clenshaw_b1;
+        std::vector<glm::dvec2>& b2 = clenshaw_b2;
+        b1.clear();
+        b2.clear();
+
+        for (int k = degree; k >= 0; --k) {
+            int target = degree - k;
+            double scale = k == 0 ? 1.0 : 2.0;
+
+            if (b1.empty()) {
+                b0.assign(1, glm::dvec2(0.0));
+            } else {
+                multiply_by_x(b1, b0);
+            }
+            elevate_to(b2, target);
+
+            for (int i = 0; i <= target; ++i) {
+                b0[i] = coefficients[k] + scale * b0[i] - b2[i];
+            }
+
+            std::swap(b2, b1);
+            std::swap(b1, b0);
+        }
+
+        for (int i = 0; i <= degree; ++i) {
+            points[i] = b1[i];
+        }
+    }
+
+    glm::dvec2 evaluate_chebyshev(const glm::dvec2* coefficients, int degree, double t)
+    {
+        double x = 2.0 * t - 1.0;
+        glm::dvec2 b1(0.0);
+        glm::dvec2 b2(0.0);
+
+        for (int k = degree; k >= 1; --k) {
+            glm::dvec2 b0 = coefficients[k] + 2.0 * x * b1 - b2;
+            b2 = b1;
+            b1 = b0;
+        }
+
+        return coefficients[0] + x * b1 - b2;
+    }
+
+    void evaluate_chebyshev_curve(const glm::dvec2* coefficients, int degree, int num_samples, glm::vec2* out)
+    {
+        assert(num_samples > 1);
+
+        for (int j = 0; j < num_samples; ++j) {
+            double t = (double)j / (num_samples - 1);
+            out[j] = glm::vec2(evaluate_chebyshev(coefficients, degree, t));
+        }
+    }
+
+    double chebyshev_node(int j, int num_nodes)
+    {
+        // (1 + x) / 2 for the node x = cos(pi (2(n - 1 - j) + 1) / 2n)
+        double s = std::sin(std::numbers::pi * (2 * j + 1) / (4.0 * num_nodes));
+        return s * s;
+    }
+
+    void evaluate_chebyshev_nodes(const glm::dvec2* coefficients, int degree, int num_nodes, glm::vec2* out)
+    {
+        int n = num_nodes;
+        assert(n >= 2 && n > degree && (n & (n - 1)) == 0);
+
+        auto [it, inserted] = dct_rotations.try_emplace(n);
+        std::vector<std::complex<double>>& rotations = it->second;
+        if (inserted) {
+            rotations.resize(n);
+            for (int k = 0; k < n; ++k) {
+                rotations[k] = std::polar(1.0, std::numbers::pi * k / (2.0 * n));
+            }
+        }
+
+        // Makhoul's DCT-III through one complex transform of the same size
+        // per coordinate: with z_k = (c_k - i c_(n-k)) e^(i pi k / 2n),
+        // Re v_m = 2 f_(2m) - c_0 and Re v_(n-1-m) = 2 f_(2m+1) - c_0, where
+        // f_j is the value at the node cos(pi (2j + 1) / 2n)
+        fft_work_x.resize(n);
+        fft_work_y.resize(n);
+        for (int k = 0; k < n; ++k) {
+            glm::dvec2 c = k <= degree ? coefficients[k] : glm::dvec2(0.0);
+            glm::dvec2 mirrored = k > 0 && n - k <= degree ? coefficients[n - k] : glm::dvec2(0.0);
+            fft_work_x[k] = multiply(std::complex<double>(c.x, -mirrored.x), rotations[k]);
+            fft_work_y[k] = multiply(std::complex<double>(c.y, -mirrored.y), rotations[k]);
+        }
+
+        inverse_fft(fft_work_x);
+        inverse_fft(fft_work_y);
+
+        // The nodes go from x near 1 down, out from t near 0 up
+        glm::dvec2 c0 = coefficients[0];
+        for (int m = 0; m < n / 2; ++m) {
+            glm::dvec2 even(fft_work_x[m].real(), fft_work_y[m].real());
+            glm::dvec2 odd(fft_work_x[n - 1 - m].real(), fft_work_y[n - 1 - m].real());
+            out[n - 1 - 2 * m] = glm::vec2(0.5 * (even + c0));
+            out[n - 2 - 2 * m] = glm::vec2(0.5 * (odd + c0));
+        }
+    }
+}
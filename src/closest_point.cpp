@@ -0,0 +1,207 @@
+#include "2dcurves/closest_point.h"
+#include "2dcurves/AABB.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/CurveHierarchy.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        constexpr int max_depth = 12;
+
+        // Leaves deviate from their chord by at most this fraction of the
+        // size of the curve
+        constexpr float flatness = 1e-2f;
+
+        constexpr int max_newton_iterations = 4;
+
+        bool is_flat(const glm::vec3* points, int degree, float tolerance)
+        {
+            glm::vec2 a = project(points[0]);
+            glm::vec2 b = project(points[degree]);
+            glm::vec2 chord = b - a;
+            float chord_length2 = glm::dot(chord, chord);
+
+            for (int i = 1; i < degree; ++i) {
+                glm::vec2 p = project(points[i]) - a;
+                float h = chord_length2 > 0.0f ? std::clamp(glm::dot(p, chord) / chord_length2, 0.0f, 1.0f) : 0.0f;
+                if (glm::length(p - h * chord) > tolerance) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        int build_node(CurveHierarchy& hierarchy, float t0, float t1, int first_point, int depth, float tolerance)
+        {
+            int degree = hierarchy.degree;
+            int index = hierarchy.nodes.size();
+
+            CurveHierarchy::Node node;
+            node.t0 = t0;
+            node.t1 = t1;
+            node.first_point = first_point;
+            for (int i = 0; i <= degree; ++i) {
+                node.bounds.expand(project(hierarchy.points[first_point + i]));
+            }
+            hierarchy.nodes.push_back(node);
+
+            if (depth == max_depth || is_flat(hierarchy.points.data() + first_point, degree, tolerance)) {
+                return index;
+            }
+
+            // Halves of the piece, which stay inside their own control polygons
+            int left_first = hierarchy.points.size();
+            int right_first = left_first + degree + 1;
+            hierarchy.points.resize(right_first + degree + 1);
+            split_bezier(
+                hierarchy.points.data() + first_point,
+                degree,
+                0.5f,
+                hierarchy.points.data() + left_first,
+                hierarchy.points.data() + right_first
+            );
+
+            float t_mid = 0.5f * (t0 + t1);
+            int left = build_node(hierarchy, t0, t_mid, left_first, depth + 1, tolerance);
+            int right = build_node(hierarchy, t_mid, t1, right_first, depth + 1, tolerance);
+            hierarchy.nodes[index].left = left;
+            hierarchy.nodes[index].right = right;
+
+            return index;
+        }
+
+        float box_distance2(const AABB& box, glm::vec2 point)
+        {
+            glm::vec2 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec2(0.0f, 0.0f));
+            return glm::dot(d, d);
+        }
+
+        // Local minimum of the distance to point on a nearly flat piece,
+        // starting from the projection onto its chord
+        float refine(const glm::vec3* points, int degree, glm::vec2 point)
+        {
+            glm::vec2 a = project(points[0]);
+            glm::vec2 chord = project(points[degree]) - a;
+            float chord_length2 = glm::dot(chord, chord);
+
+            float s = 0.0f;
+            if (chord_length2 > 0.0f) {
+                s = std::clamp(glm::dot(point - a, chord) / chord_length2, 0.0f, 1.0f);
+            }
+
+            // Newton on f(s) = C'(s) . (C(s) - point)
+            for (int i = 0; i < max_newton_iterations; ++i) {
+                glm::vec2 c, c1, c2;
+                evaluate_bezier_derivatives(points, degree, s, c, c1, c2);
+
+                glm::vec2 difference = c - point;
+                float f = glm::dot(c1, difference);
+                float df = glm::dot(c2, difference) + glm::dot(c1, c1);
+                if (df <= 0.0f) {
+                    break;
+                }
+
+                float next = std::clamp(s - f / df, 0.0f, 1.0f);
+                if (std::abs(next - s) < 1e-7f) {
+                    break;
+                }
+                s = next;
+            }
+
+            return s;
+        }
+    }
+
+    const CurveHierarchy& curve_hierarchy(Curve& curve)
+    {
+        assert(curve.num_vertices > 0);
+
+        CurveHierarchy& hierarchy = curve.hierarchy;
+        if (hierarchy.revision == curve.revision) {
+            return hierarchy;
+        }
+
+        std::vector<glm::vec3> piece_points;
+        std::vector<float> breaks;
+        int degree = bezier_pieces(curve, piece_points, breaks);
+
+        hierarchy.degree = degree;
+        hierarchy.nodes.clear();
+        hierarchy.roots.clear();
+        hierarchy.points = piece_points;
+
+        glm::vec2 size = curve.bounds.size();
+        float tolerance = flatness * std::max(size.x, size.y);
+
+        for (int k = 0; k + 1 < (int)breaks.size(); ++k) {
+            int root = build_node(hierarchy, breaks[k], breaks[k + 1], k * (degree + 1), 0, tolerance);
+            hierarchy.roots.push_back(root);
+        }
+
+        hierarchy.revision = curve.revision;
+        return hierarchy;
+    }
+
+    ClosestPoint closest_point(Curve& curve, glm::vec2 point)
+    {
+        const CurveHierarchy& hierarchy = curve_hierarchy(curve);
+        int degree = hierarchy.degree;
+
+        ClosestPoint res{0.0f, glm::vec2(0.0f, 0.0f), std::numeric_limits<float>::infinity()};
+        float best_distance2 = std::numeric_limits<float>::infinity();
+
+        thread_local std::vector<int> stack;
+        stack.assign(hierarchy.roots.rbegin(), hierarchy.roots.rend());
+
+        while (!stack.empty()) {
+            const CurveHierarchy::Node& node = hierarchy.nodes[stack.back()];
+            stack.pop_back();
+
+            if (box_distance2(node.bounds, point) >= best_distance2) {
+                continue;
+            }
+
+            const glm::vec3* points = hierarchy.points.data() + node.first_point;
+
+            if (node.left == -1) {
+                float s = refine(points, degree, point);
+
+                glm::vec2 c, c1, c2;
+                evaluate_bezier_derivatives(points, degree, s, c, c1, c2);
+
+                glm::vec2 difference = c - point;
+                float distance2 = glm::dot(difference, difference);
+                if (distance2 < best_distance2) {
+                    best_distance2 = distance2;
+                    res.t = node.t0 + s * (node.t1 - node.t0);
+                    res.point = c;
+                }
+                continue;
+            }
+
+            // Visit the nearer child first
+            int nearer = node.left;
+            int farther = node.right;
+            if (box_distance2(hierarchy.nodes[farther].bounds, point) < box_distance2(hierarchy.nodes[nearer].bounds, point)) {
+                std::swap(nearer, farther);
+            }
+            stack.push_back(farther);
+            stack.push_back(nearer);
+        }
+
+        res.distance = std::sqrt(best_distance2);
+        return res;
+    }
+}
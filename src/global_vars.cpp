@@ -0,0 +1,16 @@
+#include "2dcurves/global_vars.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/Vertex.h"
+
+#include <vector>
+
+// Initialize the global variables shared by the application and the
+// benchmarks. The ones tied to the user interface are defined in main.cpp.
+std::vector<Vertex> control_vertices;
+std::vector<Curve> scene_curves(1);
+int num_samples = 200;
+bool arc_length_sampling = false;
+evaluation_precision sample_precision = evaluation_precision::float32;
+Camera camera;
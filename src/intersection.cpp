@@ -0,0 +1,266 @@
+#include "2dcurves/intersection.h"
+#include "2dcurves/AABB.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/closest_point.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/CurveHierarchy.h"
+#include "2dcurves/global_vars.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        constexpr int max_newton_iterations = 8;
+
+        // Parameter distance under which two roots are the same intersection
+        constexpr float duplicate_tolerance = 1e-4f;
+
+        struct Piece
+        {
+            const glm::vec3* points;
+            int degree;
+        };
+
+        Piece node_piece(const CurveHierarchy& hierarchy, const CurveHierarchy::Node& node)
+        {
+            return Piece{hierarchy.points.data() + node.first_point, hierarchy.degree};
+        }
+
+        // True if the control points of other all lie on one side of the fat
+        // line of piece, the strip parallel to its chord that holds its
+        // control polygon
+        bool fat_line_separates(const Piece& piece, const Piece& other)
+        {
+            glm::vec2 a = project(piece.points[0]);
+            glm::vec2 chord = project(piece.points[piece.degree]) - a;
+            float chord_length = glm::length(chord);
+            if (chord_length == 0.0f) {
+                return false;
+            }
+            glm::vec2 normal = glm::vec2(-chord.y, chord.x) / chord_length;
+
+            float d_min = 0.0f;
+            float d_max = 0.0f;
+            for (int i = 1; i < piece.degree; ++i) {
+                float d = glm::dot(project(piece.points[i]) - a, normal);
+                d_min = std::min(d_min, d);
+                d_max = std::max(d_max, d);
+            }
+
+            bool all_below = true;
+            bool all_above = true;
+            for (int i = 0; i <= other.degree; ++i) {
+                float d = glm::dot(project(other.points[i]) - a, normal);
+                all_below = all_below && d < d_min;
+                all_above = all_above && d > d_max;
+            }
+
+            return all_below || all_above;
+        }
+
+        // Solves A(s) = B(u) on two pieces starting from (s, u). Returns false
+        // if the iteration leaves the pieces or does not converge.
+        bool refine(const Piece& a, const Piece& b, float& s, float& u, glm::vec2& point, float tolerance)
+        {
+            for (int i = 0; i < max_newton_iterations; ++i) {
+                glm::vec2 pa, da, dda;
+                glm::vec2 pb, db, ddb;
+                evaluate_bezier_derivatives(a.points, a.degree, s, pa, da, dda);
+                evaluate_bezier_derivatives(b.points, b.degree, u, pb, db, ddb);
+
+                glm::vec2 f = pa - pb;
+                if (glm::length(f) <= tolerance) {
+                    point = 0.5f * (pa + pb);
+                    return true;
+                }
+
+                // Jacobian [da, -db]
+                float determinant = -da.x * db.y + db.x * da.y;
+                if (std::abs(determinant) < 1e-20f) {
+                    return false;
+                }
+
+                float ds = (-f.x * -db.y + db.x * -f.y) / determinant;
+                float du = (da.x * -f.y - -f.x * da.y) / determinant;
+                s += ds;
+                u += du;
+
+                if (s < -0.01f || s > 1.01f || u < -0.01f || u > 1.01f) {
+                    return false;
+                }
+                s = std::clamp(s, 0.0f, 1.0f);
+                u = std::clamp(u, 0.0f, 1.0f);
+            }
+
+            return false;
+        }
+
+        // Starting parameters for a pair of flat pieces, from the
+        // intersection of their chords
+        bool chord_intersection(const Piece& a, const Piece& b, float& s, float& u)
+        {
+            glm::vec2 a0 = project(a.points[0]);
+            glm::vec2 a1 = project(a.points[a.degree]);
+            glm::vec2 b0 = project(b.points[0]);
+            glm::vec2 b1 = project(b.points[b.degree]);
+
+            glm::vec2 da = a1 - a0;
+            glm::vec2 db = b1 - b0;
+            float denominator = da.x * db.y - da.y * db.x;
+            if (denominator == 0.0f) {
+                s = 0.5f;
+                u = 0.5f;
+                return true;
+            }
+
+            glm::vec2 offset = b0 - a0;
+            s = (offset.x * db.y - offset.y * db.x) / denominator;
+            u = (offset.x * da.y - offset.y * da.x) / denominator;
+
+            // Flat pieces may cross slightly outside of their chords
+            const float margin = 0.25f;
+            if (s < -margin || s > 1.0f + margin || u < -margin || u > 1.0f + margin) {
+                return false;
+            }
+
+            s = std::clamp(s, 0.0f, 1.0f);
+            u = std::clamp(u, 0.0f, 1.0f);
+            return true;
+        }
+
+        float diagonal(const AABB& box)
+        {
+            return glm::length(box.size());
+        }
+    }
+
+    void intersect_curves(int curve_a, int curve_b, std::vector<Intersection>& out)
+    {
+        Curve& a = scene_curves[curve_a];
+        Curve& b = scene_curves[curve_b];
+        if (a.num_vertices == 0 || b.num_vertices == 0 || !a.bounds.overlaps(b.bounds)) {
+            return;
+        }
+
+        const CurveHierarchy& hierarchy_a = curve_hierarchy(a);
+        const CurveHierarchy& hierarchy_b = curve_hierarchy(b);
+
+        float tolerance = 1e-5f * std::max(diagonal(a.bounds), diagonal(b.bounds));
+        std::size_t first_found = out.size();
+
+        thread_local std::vector<std::pair<int, int>> stack;
+        stack.clear();
+        for (int root_a : hierarchy_a.roots) {
+            for (int root_b : hierarchy_b.roots) {
+                stack.push_back({root_a, root_b});
+            }
+        }
+
+        while (!stack.empty()) {
+            auto [index_a, index_b] = stack.back();
+            stack.pop_back();
+
+            const CurveHierarchy::Node& node_a = hierarchy_a.nodes[index_a];
+            const CurveHierarchy::Node& node_b = hierarchy_b.nodes[index_b];
+            if (!node_a.bounds.overlaps(node_b.bounds)) {
+                continue;
+            }
+
+            Piece piece_a = node_piece(hierarchy_a, node_a);
+            Piece piece_b = node_piece(hierarchy_b, node_b);
+            if (fat_line_separates(piece_a, piece_b) || fat_line_separates(piece_b, piece_a)) {
+                continue;
+            }
+
+            bool leaf_a = node_a.left == -1;
+            bool leaf_b = node_b.left == -1;
+
+            if (leaf_a && leaf_b) {
+                float s, u;
+                glm::vec2 point;
+                if (!chord_intersection(piece_a, piece_b, s, u) || !refine(piece_a, piece_b, s, u, point, tolerance)) {
+                    continue;
+                }
+
+                float t_a = node_a.t0 + s * (node_a.t1 - node_a.t0);
+                float t_b = node_b.t0 + u * (node_b.t1 - node_b.t0);
+
+                // Roots on the border of neighbouring leaves are found twice
+                bool duplicate = std::any_of(out.begin() + first_found, out.end(), [&](const Intersection& found) {
+                    return std::abs(found.t_a - t_a) < duplicate_tolerance &&
+                           std::abs(found.t_b - t_b) < duplicate_tolerance;
+                });
+
+                if (!duplicate) {
+                    out.push_back(Intersection{curve_a, curve_b, t_a, t_b, point});
+                }
+                continue;
+            }
+
+            // Split the larger of the two pieces
+            if (leaf_b || (!leaf_a && diagonal(node_a.bounds) >= diagonal(node_b.bounds))) {
+                stack.push_back({node_a.left, index_b});
+                stack.push_back({node_a.right, index_b});
+            } else {
+                stack.push_back({index_a, node_b.left});
+                stack.push_back({index_a, node_b.right});
+            }
+        }
+    }
+
+    void overlapping_curve_pairs(const std::vector<Curve>& curves, std::vector<std::pair<int, int>>& out)
+    {
+        // The sweep only touches the boxes, so keep them packed apart from
+        // the much larger curves
+        std::vector<AABB> boxes(curves.size());
+        std::vector<int> order;
+        order.reserve(curves.size());
+        for (int c = 0; c < (int)curves.size(); ++c) {
+            boxes[c] = curves[c].bounds;
+            if (!boxes[c].empty()) {
+                order.push_back(c);
+            }
+        }
+
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return boxes[a].min.x < boxes[b].min.x;
+        });
+
+        // Curves whose x extent still overlaps the sweep position
+        std::vector<int> active;
+        for (int c : order) {
+            float x = boxes[c].min.x;
+
+            active.erase(
+                std::remove_if(active.begin(), active.end(), [&](int a) { return boxes[a].max.x < x; }),
+                active.end()
+            );
+
+            for (int a : active) {
+                if (boxes[a].overlaps(boxes[c])) {
+                    out.push_back({std::min(a, c), std::max(a, c)});
+                }
+            }
+
+            active.push_back(c);
+        }
+    }
+
+    void scene_intersections(std::vector<Intersection>& out)
+    {
+        std::vector<std::pair<int, int>> pairs;
+        overlapping_curve_pairs(scene_curves, pairs);
+
+        for (auto [a, b] : pairs) {
+            intersect_curves(a, b, out);
+        }
+    }
+}
@@ -1,34 +1,120 @@
 #define GLFW_INCLUDE_NONE
 
+#include "2dcurves/AABB.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/closest_point.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/EditLog.h"
+#include "2dcurves/FrameSnapshot.h"
 #include "2dcurves/global_vars.h"
+#include "2dcurves/GpuTessellator.h"
+#include "2dcurves/GpuTimer.h"
+#include "2dcurves/intersection.h"
+#include "2dcurves/LatencyTracker.h"
+#include "2dcurves/RenderThread.h"
+#include "2dcurves/scene.h"
+#include "2dcurves/scene_file.h"
 #include "2dcurves/Shader.h"
+#include "2dcurves/shader_data.h"
+#include "2dcurves/StatsHud.h"
+#include "2dcurves/StripBatch.h"
+#include "2dcurves/tessellation.h"
 #include "2dcurves/utils.h"
 #include "2dcurves/Vertex.h"
+#include "2dcurves/VertexSelection.h"
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <glm/mat3x3.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <cstdlib>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <vector>
 
 
 enum class mode {drawing, editing};
 enum class visibility {show, hide};
+enum class selection_gesture {none, box, lasso};
 
-// Initialize global variables
-std::vector<Vertex> control_vertices;
+// Initialize global variables, the scene ones live in global_vars.cpp
 mode active_mode = mode::drawing;
 visibility active_visibility = visibility::show;
-int num_samples = 200;
-std::vector<float> t_samples = curves::linspace(0.0f, 1.0f, num_samples);
+line_style active_line_style = line_style::strip;
 
+// Print the GPU time of the curve pass and the input latency periodically
+bool report_frame_times = false;
+
+// Draw the statistics HUD
+bool show_stats = false;
+
+// Read the cursor for dragged vertices right before their upload rather
+// than at the start of the frame
+bool late_latch_cursor = false;
+
+// Time of the oldest input event not yet shown by a frame, negative if none
+double pending_input_time = -1.0;
+
+// Tessellate with the compute shader rather than on the CPU, when sampling
+// is uniform and in float
+bool gpu_tessellation = false;
+
+// Sleep until input arrives instead of redrawing continuously
+bool event_driven_redraw = true;
+
+// Draw on a render thread fed with frame snapshots, the main thread only
+// handles input and updates the scene
+bool threaded_rendering = false;
+
+// Upper bound on the time between two frames while waiting for events
+constexpr double idle_redraw_interval = 1.0;
+
+// Saved and opened with W and O
+const char* scene_file_path = "scene.txt";
+
+// A vertex drag is open as an undo step
+bool drag_edit_open = false;
+
+// Selected control vertices in editing mode. Dragging one of them moves
+// them all, from drag_position to the cursor.
+VertexSelection selected_vertices;
+bool dragging_selection = false;
+glm::vec2 drag_position;
+
+// Shift drags a box, Ctrl a lasso, adding the vertices inside to the
+// selection. Holds the corner the box started from, or the lasso so far,
+// in world coordinates.
+selection_gesture active_gesture = selection_gesture::none;
+std::vector<glm::vec2> gesture_points;
+
+// Rotation and scale steps of the selection, about its center
+constexpr float selection_rotation_step = 0.2617994f;
+constexpr float selection_scale_step = 1.25f;
+
+// Every edit is logged to these files and the scene recovered from them at
+// startup, see EditLog
+const char* snapshot_path = "autosave.snapshot";
+const char* edit_log_path = "autosave.log";
+EditLog* edit_log = nullptr;
+
+
+// Earlier of two input times, negative meaning none
+static double earliest_time(double a, double b)
+{
+    if (a < 0.0) {
+        return b;
+    }
+    return b < 0.0 ? a : std::min(a, b);
+}
 
 // Callbacks
 static void error_callback(int error, const char* description)
@@ -36,32 +122,105 @@ static void error_callback(int error, const char* description)
     std::cerr << "Error: " << description << std::endl;
 }
 
+// Events are stamped when GLFW delivers them, time spent in the system
+// queue before the loop polls is not counted
+static void record_input()
+{
+    if (pending_input_time < 0.0) {
+        pending_input_time = glfwGetTime();
+    }
+}
+
+static void clear_selection()
+{
+    selected_vertices.clear();
+    curves::flag_selected_curves(selected_vertices);
+}
+
+// Everything drawn between entering and leaving drawing mode is undone as
+// one step
+static void set_mode(mode new_mode)
+{
+    if (new_mode == active_mode) {
+        return;
+    }
+
+    if (new_mode == mode::drawing) {
+        clear_selection();
+        curves::begin_edit();
+    } else {
+        curves::end_edit();
+    }
+    active_mode = new_mode;
+}
+
+// Rotates by angle and scales by factor the selected vertices, about the
+// center of their bounds
+static void transform_selection(float angle, float factor)
+{
+    if (selected_vertices.empty()) {
+        return;
+    }
+
+    glm::vec2 center = curves::selection_bounds(selected_vertices).center();
+    float c = factor * std::cos(angle);
+    float s = factor * std::sin(angle);
+    glm::vec2 rotated_center(c * center.x - s * center.y, s * center.x + c * center.y);
+
+    glm::mat3 transform(
+        glm::vec3(c, s, 0.0f),
+        glm::vec3(-s, c, 0.0f),
+        glm::vec3(center - rotated_center, 1.0f)
+    );
+    curves::transform_vertices(selected_vertices, transform);
+}
+
+static void log_edit(const EditRecord* record, bool forward)
+{
+    if (record != nullptr) {
+        edit_log->append(*record, forward);
+    } else {
+        edit_log->snapshot();
+    }
+}
+
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    record_input();
+
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 
     if ((key == GLFW_KEY_0 || key == GLFW_KEY_KP_0) && action == GLFW_PRESS) {
         if (active_mode == mode::editing) {
-            glm::vec2 cursor_position_NDC = curves::get_cursor_position_NDC(window);
-            Vertex new_vertex(cursor_position_NDC);
-            control_vertices.push_back(new_vertex);
-        
-            active_mode = mode::drawing;
+            set_mode(mode::drawing);
+
+            glm::vec2 cursor_position_world = curves::get_cursor_position_world(window, camera);
+            curves::add_vertex(cursor_position_world);
         }
     }
 
     if ((key == GLFW_KEY_1 || key == GLFW_KEY_KP_1) && action == GLFW_PRESS) {
-        if (active_mode == mode::drawing) {
-            control_vertices.pop_back();
-            active_mode = mode::editing;
+        if (active_mode == mode::drawing && scene_curves.back().num_vertices > 0) {
+            curves::remove_last_vertex();
+            set_mode(mode::editing);
+        }
+    }
+
+    if (key == GLFW_KEY_N && action == GLFW_PRESS) {
+        if (active_mode == mode::editing) {
+            set_mode(mode::drawing);
+
+            curves::start_new_curve();
         }
     }
 
     if (key == GLFW_KEY_C && action == GLFW_PRESS) {
-        control_vertices.clear();
-        active_mode = mode::drawing;
+        set_mode(mode::editing);
+        clear_selection();
+        curves::clear_scene();
+        set_mode(mode::drawing);
     }
 
     if (key == GLFW_KEY_S && action == GLFW_PRESS) {
@@ -71,55 +230,365 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
     if (key == GLFW_KEY_H && action == GLFW_PRESS) {
         active_visibility = visibility::hide;
     }
+
+    if (key == GLFW_KEY_U && action == GLFW_PRESS) {
+        if (active_mode == mode::editing) {
+            int last_curve = scene_curves.size() - 1;
+            const Curve& curve = scene_curves[last_curve];
+
+            if (!curve.knots.empty()) {
+                curves::set_curve_knots(last_curve, {});
+            } else if (curve.num_vertices >= 2) {
+                int degree = std::min(3, curve.num_vertices - 1);
+                curves::set_curve_knots(last_curve, curves::clamped_uniform_knots(curve.num_vertices, degree));
+            }
+        }
+    }
+
+    if (key == GLFW_KEY_E && action == GLFW_PRESS) {
+        if (active_mode == mode::editing) {
+            curves::elevate_degree();
+        }
+    }
+
+    if (key == GLFW_KEY_R && action == GLFW_PRESS) {
+        if (active_mode == mode::editing) {
+            curves::reduce_degree();
+        }
+    }
+
+    if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+        if (active_mode == mode::editing && scene_curves.back().num_vertices > 0) {
+            glm::vec2 cursor_pos_world = curves::get_cursor_position_world(window, camera);
+            curves::split_curve(curves::closest_point(scene_curves.back(), cursor_pos_world).t);
+        }
+    }
+
+    if ((key == GLFW_KEY_EQUAL || key == GLFW_KEY_MINUS) && action == GLFW_PRESS) {
+        if (active_mode == mode::editing) {
+            glm::vec2 cursor_pos_world = curves::get_cursor_position_world(window, camera);
+            float factor = key == GLFW_KEY_EQUAL ? 1.5f : 1.0f / 1.5f;
+
+            curves::begin_edit();
+            for (int c = 0; c < (int)scene_curves.size(); ++c) {
+                const Curve& curve = scene_curves[c];
+                for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                    if (glm::distance(control_vertices[i].position, cursor_pos_world) < 0.03 / camera.zoom) {
+                        curves::set_vertex_weight(c, i, control_vertices[i].weight * factor);
+                    }
+                }
+            }
+            curves::end_edit();
+        }
+    }
+
+    if ((key == GLFW_KEY_LEFT_BRACKET || key == GLFW_KEY_RIGHT_BRACKET) && action != GLFW_RELEASE) {
+        if (active_mode == mode::editing) {
+            transform_selection(key == GLFW_KEY_LEFT_BRACKET ? selection_rotation_step : -selection_rotation_step, 1.0f);
+        }
+    }
+
+    if ((key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD) && action != GLFW_RELEASE) {
+        if (active_mode == mode::editing) {
+            transform_selection(0.0f, key == GLFW_KEY_PERIOD ? selection_scale_step : 1.0f / selection_scale_step);
+        }
+    }
+
+    if (key == GLFW_KEY_A && action == GLFW_PRESS) {
+        arc_length_sampling = !arc_length_sampling;
+        for (Curve& curve : scene_curves) {
+            curve.dirty = true;
+        }
+    }
+
+    if (key == GLFW_KEY_D && action == GLFW_PRESS) {
+        const char* name = "float";
+        if (sample_precision == evaluation_precision::float32) {
+            sample_precision = evaluation_precision::float64;
+            name = "double";
+        } else if (sample_precision == evaluation_precision::float64) {
+            sample_precision = evaluation_precision::compensated;
+            name = "compensated";
+        } else {
+            sample_precision = evaluation_precision::float32;
+        }
+        for (Curve& curve : scene_curves) {
+            curve.dirty = true;
+        }
+        std::cout << "Evaluating curves in " << name << " arithmetic" << std::endl;
+    }
+
+    if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+        if (active_line_style == line_style::strip) {
+            active_line_style = line_style::batched_strip;
+        } else if (active_line_style == line_style::batched_strip) {
+            active_line_style = line_style::wide;
+        } else {
+            active_line_style = line_style::strip;
+        }
+    }
+
+    if (key == GLFW_KEY_B && action == GLFW_PRESS) {
+        // Many long, wide and overlapping curves to stress fill rate
+        set_mode(mode::editing);
+        clear_selection();
+        curves::generate_random_scene(2000, 6, 8.0f, 1);
+        active_visibility = visibility::hide;
+        report_frame_times = true;
+        event_driven_redraw = false;
+    }
+
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+        gpu_tessellation = !gpu_tessellation;
+        std::cout << (gpu_tessellation ? "Tessellating on the GPU" : "Tessellating on the CPU") << std::endl;
+        if (gpu_tessellation && (arc_length_sampling || sample_precision != evaluation_precision::float32)) {
+            std::cout << "Only uniform float sampling runs on the GPU, staying on the CPU until then" << std::endl;
+        }
+    }
+
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+        threaded_rendering = !threaded_rendering;
+        std::cout << (threaded_rendering ? "Rendering on a render thread" : "Rendering on the main thread") << std::endl;
+        if (threaded_rendering && gpu_tessellation) {
+            std::cout << "The render thread draws curves tessellated on the CPU" << std::endl;
+        }
+    }
+
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+        report_frame_times = !report_frame_times;
+    }
+
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        show_stats = !show_stats;
+        if (show_stats) {
+            std::cout << "Statistics from the top: visible curves, samples, KB uploaded, CPU ms, GPU ms of the curve pass"
+                      << std::endl;
+        }
+    }
+
+    if (key == GLFW_KEY_K && action == GLFW_PRESS) {
+        late_latch_cursor = !late_latch_cursor;
+        std::cout << (late_latch_cursor ? "Cursor read before upload" : "Cursor read at frame start") << std::endl;
+    }
+
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<curves::Intersection> intersections;
+        curves::scene_intersections(intersections);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << intersections.size() << " intersections between " << scene_curves.size()
+                  << " curves (" << milliseconds << " ms)" << std::endl;
+    }
+
+    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        event_driven_redraw = !event_driven_redraw;
+        std::cout << (event_driven_redraw ? "Redrawing on input" : "Redrawing continuously") << std::endl;
+    }
+
+    if (key == GLFW_KEY_W && action == GLFW_PRESS) {
+        std::ofstream file(scene_file_path);
+        curves::write_scene(file);
+        std::cout << (file ? "Saved " : "Could not save ") << scene_file_path << std::endl;
+    }
+
+    if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        std::ifstream file(scene_file_path);
+        if (file) {
+            set_mode(mode::editing);
+            clear_selection();
+        }
+        if (file && curves::load_scene(file)) {
+            std::cout << "Opened " << scene_file_path << std::endl;
+        } else {
+            std::cout << "Could not open " << scene_file_path << std::endl;
+        }
+    }
+
+    if ((key == GLFW_KEY_Z || key == GLFW_KEY_Y) && action != GLFW_RELEASE) {
+        if (active_mode == mode::editing) {
+            bool applied = key == GLFW_KEY_Z ? curves::undo() : curves::redo();
+            if (!applied) {
+                std::cout << (key == GLFW_KEY_Z ? "Nothing to undo" : "Nothing to redo") << std::endl;
+            }
+
+            // Vertices keep their indices, but undo can remove some
+            selected_vertices.resize(control_vertices.size());
+            curves::flag_selected_curves(selected_vertices);
+        }
+    }
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
+    record_input();
+
+    // A drag is one undo step, even if the mode changed meanwhile
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE && drag_edit_open) {
+        curves::end_edit();
+        drag_edit_open = false;
+    }
+
     if (active_mode == mode::drawing) {
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-            glm::vec2 cursor_pos_NDC = curves::get_cursor_position_NDC(window);
-
-            if (control_vertices.empty()) {
-                Vertex first_vertex(cursor_pos_NDC);
-                control_vertices.push_back(first_vertex);
+            glm::vec2 cursor_pos_world = curves::get_cursor_position_world(window, camera);
+            const Curve& active_curve = scene_curves.back();
 
-                Vertex second_vertex(cursor_pos_NDC);
-                control_vertices.push_back(second_vertex);
+            if (active_curve.num_vertices == 0) {
+                curves::add_vertex(cursor_pos_world);
+                curves::add_vertex(cursor_pos_world);
             }
 
-            Vertex new_vertex(cursor_pos_NDC);
-            if (control_vertices.size() <= 50) {
-                control_vertices.push_back(new_vertex);
+            // The limit of degree elevation too
+            if (active_curve.num_vertices <= curves::max_bezier_degree) {
+                curves::add_vertex(cursor_pos_world);
             } else {
-                std::cerr << "Bézier curves with more than 51 vertices are not "
-                        << "allowed to avoid overflow problems" << std::endl;
-                exit(EXIT_FAILURE);
+                std::cerr << "Bézier curves with more than " << curves::max_bezier_degree + 1
+                        << " vertices are not supported" << std::endl;
             }
         }
 
         if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
-            control_vertices.pop_back();
-            active_mode = mode::editing;
+            curves::remove_last_vertex();
+            set_mode(mode::editing);
         }
     } else if (active_mode == mode::editing) {
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-            glm::vec2 cursor_pos_NDC = curves::get_cursor_position_NDC(window);
+            glm::vec2 cursor_pos_world = curves::get_cursor_position_world(window, camera);
+
+            if (mods & (GLFW_MOD_SHIFT | GLFW_MOD_CONTROL)) {
+                active_gesture = (mods & GLFW_MOD_SHIFT) ? selection_gesture::box : selection_gesture::lasso;
+                gesture_points.assign(1, cursor_pos_world);
+                return;
+            }
+
+            // Pick radius is constant on screen
+            float radius = 0.03f / camera.zoom;
+            AABB pick_box;
+            pick_box.min = cursor_pos_world - glm::vec2(radius);
+            pick_box.max = cursor_pos_world + glm::vec2(radius);
+
+            VertexSelection picked;
+            curves::select_vertices_in_box(pick_box, picked);
 
-            for (Vertex& v : control_vertices) {
-                if (glm::distance(v.position, cursor_pos_NDC) < 0.03) {
-                    v.is_moving = true;
+            bool picked_any = false;
+            bool picked_selected = false;
+            picked.forEachRun([&](int first, int count) {
+                for (int i = first; i < first + count; ++i) {
+                    if (glm::distance(control_vertices[i].position, cursor_pos_world) < radius) {
+                        picked_any = true;
+                        picked_selected = picked_selected || selected_vertices.contains(i);
+                    } else {
+                        picked.erase(i);
+                    }
                 }
+            });
+
+            // Clicking a selected vertex drags the whole selection, any
+            // other vertex replaces it, empty space clears it
+            if (!picked_selected) {
+                selected_vertices = picked;
+                curves::flag_selected_curves(selected_vertices);
+            }
+
+            if (picked_any) {
+                if (!drag_edit_open) {
+                    curves::begin_edit();
+                    drag_edit_open = true;
+                }
+                dragging_selection = true;
+                drag_position = cursor_pos_world;
             }
         }
 
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-            for (Vertex& v : control_vertices) {
-                v.is_moving = false;
+            glm::vec2 cursor_pos_world = curves::get_cursor_position_world(window, camera);
+
+            if (active_gesture == selection_gesture::box) {
+                AABB box;
+                box.expand(gesture_points[0]);
+                box.expand(cursor_pos_world);
+                curves::select_vertices_in_box(box, selected_vertices);
+            } else if (active_gesture == selection_gesture::lasso) {
+                curves::select_vertices_in_lasso(gesture_points, selected_vertices);
+            }
+            if (active_gesture != selection_gesture::none) {
+                curves::flag_selected_curves(selected_vertices);
+                active_gesture = selection_gesture::none;
             }
+
+            dragging_selection = false;
         }
     }
 }
 
+static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    record_input();
+
+    glm::vec2 cursor_pos_NDC = curves::get_cursor_position_NDC(window);
+    curves::zoom_camera(camera, cursor_pos_NDC, std::pow(1.1f, (float)yoffset));
+}
+
+static void cursor_position_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    record_input();
+}
+
+// Moves the vertex following the cursor in drawing mode and the dragged
+// selection in editing mode. Returns whether any vertex follows the cursor.
+static bool move_vertices_to_cursor(glm::vec2 cursor_position_world, bool dragging)
+{
+    bool moved = false;
+
+    if (active_mode == mode::drawing && scene_curves.back().num_vertices > 0) {
+        int last_curve = scene_curves.size() - 1;
+        curves::move_vertex(last_curve, control_vertices.size() - 1, cursor_position_world);
+        moved = true;
+    }
+
+    if (active_mode == mode::editing && dragging && dragging_selection) {
+        if (cursor_position_world != drag_position) {
+            glm::mat3 translation(1.0f);
+            translation[2] = glm::vec3(cursor_position_world - drag_position, 1.0f);
+            curves::transform_vertices(selected_vertices, translation);
+            drag_position = cursor_position_world;
+        }
+        moved = true;
+    }
+
+    return moved;
+}
+
+// Drags and pans are driven by the cursor, they poll so that every vsync
+// picks up the latest position
+static bool redraw_continuously(GLFWwindow* window)
+{
+    if (!event_driven_redraw) {
+        return true;
+    }
+
+    return glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS ||
+           glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS;
+}
+
+// Closed outline of the selection gesture in progress, in world
+// coordinates
+static std::vector<glm::vec2> gesture_outline(glm::vec2 cursor_position_world)
+{
+    if (active_gesture != selection_gesture::box) {
+        return gesture_points;
+    }
+
+    glm::vec2 corner = gesture_points[0];
+    return {
+        corner,
+        glm::vec2(cursor_position_world.x, corner.y),
+        cursor_position_world,
+        glm::vec2(corner.x, cursor_position_world.y)
+    };
+}
+
 
 int main()
 {
@@ -144,6 +613,8 @@ int main()
     // Set callbacks
     glfwSetKeyCallback(window, key_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetCursorPosCallback(window, cursor_position_callback);
 
     glfwMakeContextCurrent(window);
 
@@ -162,75 +633,395 @@ int main()
     std::cout << "\nKEYBOARD INPUT:\n" 
               << "0: drawing mode\n" 
               << "1: editing mode\n"
+              << "N: new curve (from editing mode)\n"
+              << "U: toggle last curve between Bézier and cubic NURBS (editing mode)\n"
+              << "+/-: increase/decrease weight of the vertex under the cursor (editing mode)\n"
+              << "E/R: elevate/reduce the degree of the last Bézier curve (editing mode)\n"
+              << "X: split the last Bézier curve at the point closest to the cursor (editing mode)\n"
+              << "[/]: rotate the selected vertices (editing mode)\n"
+              << ",/.: shrink/grow the selected vertices (editing mode)\n"
               << "C: clear\n"
               << "S: show control polyline\n"
-              << "H: hide control polyline" << std::endl;
+              << "H: hide control polyline\n"
+              << "A: toggle uniform / arc length sampling\n"
+              << "D: cycle float / double / compensated evaluation\n"
+              << "L: cycle line strips / batched line strips / anti-aliased wide lines\n"
+              << "B: load fill-rate benchmark scene and report GPU time\n"
+              << "G: toggle CPU / GPU (compute shader) tessellation\n"
+              << "I: count the intersections between curves\n"
+              << "W/O: save/open scene.txt\n"
+              << "Z/Y: undo/redo (editing mode)\n"
+              << "P: toggle redrawing on input / continuously\n"
+              << "T: toggle rendering on the main thread / a render thread\n"
+              << "F: toggle periodic report of GPU time and input latency\n"
+              << "M: toggle on-screen statistics\n"
+              << "K: toggle reading the cursor for drags at frame start / right before upload"
+              << "\nMOUSE INPUT:\n"
+              << "Left click/drag: select/move vertices (editing mode)\n"
+              << "Shift/Ctrl + left drag: add the vertices in a box/lasso to the selection (editing mode)\n"
+              << "Wheel: zoom\n"
+              << "Middle button drag: pan" << std::endl;
 
     glfwSwapInterval(1);
 
 
-    // Build shader program
-    const char* vertexPath = "./shaders/vertex_shader.txt";
-    const char* fragmentPath = "./shaders/fragment_shader.txt";
-    Shader shaderProgram(vertexPath, fragmentPath);
+    // Everything owning GL objects lives in this scope, so that their
+    // destructors run while the context still exists
+    {
+        // Build shader program
+        const char* vertexPath = "./shaders/vertex_shader.txt";
+        const char* fragmentPath = "./shaders/fragment_shader.txt";
+        Shader shaderProgram(vertexPath, fragmentPath);
+        int highlight_mode_location = shaderProgram.getUniformLocation("highlight_mode");
+
+        const char* wideLineVertexPath = "./shaders/wide_line_vertex_shader.txt";
+        const char* wideLineFragmentPath = "./shaders/wide_line_fragment_shader.txt";
+        Shader wideLineProgram(wideLineVertexPath, wideLineFragmentPath);
+
+        GpuTessellator gpu_tessellator("./shaders/tessellation_compute_shader.txt");
+        StripBatch strip_batch;
+        bool gpu_tessellated = false;
 
-    // VAOs and VBOs
-    unsigned int vaos[2];
-    unsigned int vbos[2];
+        // Per-frame and per-curve shader data
+        unsigned int frame_ubo, curve_ssbo;
+        curves::create_shader_data_buffers(frame_ubo, curve_ssbo);
 
-    glGenVertexArrays(2, vaos);
-    glGenBuffers(2, vbos);
+        // VAOs and VBOs
+        unsigned int vaos[3];
+        unsigned int vbos[2];
+        unsigned int draw_id_vbo;
 
-    // Bezier curve
-    glBindVertexArray(vaos[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+        glGenVertexArrays(3, vaos);
+        glGenBuffers(2, vbos);
+        glGenBuffers(1, &draw_id_vbo);
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+        for (int i = 0; i < 3; ++i) {
+            glBindVertexArray(vaos[i]);
 
-    // Control vertices
-    glBindVertexArray(vaos[1]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
+            // Bezier curve (0) or control vertices (1), wide lines (2) read
+            // the curve samples from a storage block instead
+            if (i < 2) {
+                glBindBuffer(GL_ARRAY_BUFFER, vbos[i]);
+                glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+                glEnableVertexAttribArray(0);
+            }
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+            // One curve id per instance, offset by the draw's base instance
+            glBindBuffer(GL_ARRAY_BUFFER, draw_id_vbo);
+            glVertexAttribIPointer(curves::draw_id_attribute, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+            glVertexAttribDivisor(curves::draw_id_attribute, 1);
+            glEnableVertexAttribArray(curves::draw_id_attribute);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+        RenderThread render_thread(shaderProgram, wideLineProgram, frame_ubo, curve_ssbo, draw_id_vbo);
 
-    while (!glfwWindowShouldClose(window)) {
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        // While the render thread draws, the scene is updated at most once per
+        // refresh of the display
+        const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        double refresh_interval = 1.0 / (video_mode != NULL ? video_mode->refreshRate : 60);
 
-        glViewport(0, 0, width, height);
-        glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // Inputs of the snapshots replaced before the render thread took them,
+        // carried over to the next one
+        double dropped_input_time = -1.0;
+        double dropped_cursor_time = -1.0;
 
-        glm::vec2 cursor_position_NDC = curves::get_cursor_position_NDC(window);
 
-        if (active_mode == mode::drawing && !control_vertices.empty()) {
-            Vertex& last_vertex = control_vertices.back();
-            last_vertex.position = cursor_position_NDC;
+        EditLog autosave(snapshot_path, edit_log_path);
+        if (autosave.recover()) {
+            std::cout << "Recovered " << snapshot_path << " and " << autosave.replayedCount()
+                      << " edits from " << edit_log_path << std::endl;
+            if (!control_vertices.empty()) {
+                active_mode = mode::editing;
+            }
+        } else {
+            autosave.snapshot();
         }
+        edit_log = &autosave;
+        curves::set_edit_observer(log_edit);
 
-        int state = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
-        if (active_mode == mode::editing && state == GLFW_PRESS) {
-            for (Vertex& v : control_vertices) {
-                if (v.is_moving) {
-                    v.position = cursor_position_NDC;
+        // Drawing mode is entered through set_mode from then on
+        if (active_mode == mode::drawing) {
+            curves::begin_edit();
+        }
+
+        glm::vec2 last_cursor_position_NDC = curves::get_cursor_position_NDC(window);
+        std::vector<int> visible_curves;
+        int hovered_curve = -1;
+
+        GpuTimer curve_pass_timer;
+        double last_report_time = glfwGetTime();
+        StatsHud stats_hud(shaderProgram);
+
+        // From input events, and from the cursor reads that moved vertices
+        LatencyTracker input_latency;
+        LatencyTracker cursor_latency;
+
+        while (!glfwWindowShouldClose(window)) {
+            // The context moves to the thread that draws, and neither thread
+            // knows what the other left in its sample buffer
+            if (threaded_rendering != render_thread.running()) {
+                if (threaded_rendering) {
+                    glfwMakeContextCurrent(NULL);
+                    render_thread.start(window);
+                } else {
+                    render_thread.stop();
+                    glfwMakeContextCurrent(window);
+                }
+
+                for (Curve& curve : scene_curves) {
+                    curve.dirty = true;
+                    curve.published_samples.reset();
                 }
+                curves::invalidate_tessellation_layout();
+                gpu_tessellator.invalidate();
+                gpu_tessellated = false;
             }
-        }
+            bool threaded = render_thread.running();
+            double tick_time = glfwGetTime();
+
+            double input_time = pending_input_time;
+            pending_input_time = -1.0;
+            if (!threaded && input_time >= 0.0) {
+                input_latency.inputArrived(input_time);
+            }
+
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+
+            if (!threaded) {
+                glViewport(0, 0, width, height);
+                glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+
+            double cursor_time = glfwGetTime();
+            glm::vec2 cursor_position_NDC = curves::get_cursor_position_NDC(window);
 
-        shaderProgram.use();
-        glEnable(GL_PROGRAM_POINT_SIZE);
-        
-        curves::draw_bezier_curve(vaos[0], vbos[0]);
+            if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS) {
+                curves::pan_camera(camera, cursor_position_NDC - last_cursor_position_NDC);
+            }
+            last_cursor_position_NDC = cursor_position_NDC;
+
+            glm::vec2 cursor_position_world = curves::ndc_to_world(camera, cursor_position_NDC);
+
+            // Lasso points about a pixel apart
+            if (active_gesture == selection_gesture::lasso &&
+                glm::distance(gesture_points.back(), cursor_position_world) > 0.005f / camera.zoom) {
+                gesture_points.push_back(cursor_position_world);
+            }
+
+            // The render thread draws what the scene looked like at the start of
+            // the update, there is nothing to latch later
+            int state = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
+            double moved_cursor_time = -1.0;
+            if ((!late_latch_cursor || threaded) && move_vertices_to_cursor(cursor_position_world, state == GLFW_PRESS)) {
+                moved_cursor_time = cursor_time;
+            }
+
+            // Highlight the curve under the cursor while editing
+            if (hovered_curve != -1 && hovered_curve < (int)scene_curves.size()) {
+                scene_curves[hovered_curve].flags &= ~curve_flag_hovered;
+            }
+            hovered_curve = -1;
+            if (active_mode == mode::editing && state != GLFW_PRESS) {
+                hovered_curve = curves::pick_curve(cursor_position_world, 0.03f / camera.zoom);
+                if (hovered_curve != -1) {
+                    scene_curves[hovered_curve].flags |= curve_flag_hovered;
+                }
+            }
+
+            // Upload all shader parameters for this frame
+            curves::FrameData frame_data{};
+            frame_data.view_projection = curves::view_projection(camera);
+            frame_data.viewport_size = glm::vec2(width, height);
+            frame_data.time = glfwGetTime();
+
+            if (threaded) {
+                visible_curves.clear();
+                curves::visible_curves(camera, visible_curves);
+                curves::update_tessellations(camera, visible_curves);
+
+                std::shared_ptr<FrameSnapshot> snapshot = curves::make_frame_snapshot(
+                    camera, visible_curves, active_visibility == visibility::show, selected_vertices
+                );
+                snapshot->frame = frame_data;
+                snapshot->lines = active_line_style;
+                snapshot->report_frame_times = report_frame_times;
+                snapshot->show_stats = show_stats;
+                if (active_gesture != selection_gesture::none) {
+                    for (glm::vec2 point : gesture_outline(cursor_position_world)) {
+                        snapshot->outline.push_back(curves::camera_relative(camera, point));
+                    }
+                }
+                snapshot->input_time = earliest_time(input_time, dropped_input_time);
+                snapshot->cursor_time = earliest_time(moved_cursor_time, dropped_cursor_time);
+                snapshot->update_milliseconds = (glfwGetTime() - tick_time) * 1e3;
+
+                std::shared_ptr<const FrameSnapshot> dropped = render_thread.publish(std::move(snapshot));
+                dropped_input_time = dropped ? dropped->input_time : -1.0;
+                dropped_cursor_time = dropped ? dropped->cursor_time : -1.0;
+
+                autosave.flush();
+
+                // Callbacks run as events arrive, while waiting for the next
+                // update
+                if (!redraw_continuously(window)) {
+                    glfwWaitEventsTimeout(idle_redraw_interval);
+                }
+                for (double now = glfwGetTime(); now < tick_time + refresh_interval; now = glfwGetTime()) {
+                    glfwWaitEventsTimeout(tick_time + refresh_interval - now);
+                }
+                continue;
+            }
+
+            curves::upload_frame_data(frame_ubo, frame_data);
+
+            // Sample the cursor again once the rest of the frame is set up, so
+            // the dragged vertices are as recent as possible when uploaded. The
+            // camera is already uploaded and keeps the earlier position.
+            if (late_latch_cursor) {
+                double latched_time = glfwGetTime();
+                glm::vec2 latched_position_world = curves::get_cursor_position_world(window, camera);
+                if (move_vertices_to_cursor(latched_position_world, state == GLFW_PRESS)) {
+                    moved_cursor_time = latched_time;
+                }
+            }
+            if (moved_cursor_time >= 0.0) {
+                cursor_latency.inputArrived(moved_cursor_time);
+            }
+
+            visible_curves.clear();
+            curves::visible_curves(camera, visible_curves);
+
+            // Each path leaves the sample buffer in a state the other does not
+            // know about
+            bool use_gpu = gpu_tessellation && !arc_length_sampling && sample_precision == evaluation_precision::float32;
+            if (use_gpu != gpu_tessellated) {
+                if (use_gpu) {
+                    gpu_tessellator.invalidate();
+                } else {
+                    for (Curve& curve : scene_curves) {
+                        curve.dirty = true;
+                    }
+                }
+                gpu_tessellated = use_gpu;
+            }
+
+            if (use_gpu) {
+                gpu_tessellator.update(vbos[0], visible_curves);
+            } else {
+                curves::upload_bezier_curves(vbos[0], visible_curves);
+            }
+            curves::upload_curve_records(curve_ssbo, draw_id_vbo);
+            if (active_line_style == line_style::batched_strip) {
+                strip_batch.update(vbos[0], visible_curves);
+            }
+
+            curve_pass_timer.begin();
+            if (active_line_style == line_style::wide) {
+                wideLineProgram.use();
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+                curves::draw_wide_bezier_curve(vaos[2], vbos[0], visible_curves);
+
+                glDisable(GL_BLEND);
+            } else if (active_line_style == line_style::batched_strip) {
+                shaderProgram.use();
+                strip_batch.draw();
+            } else {
+                shaderProgram.use();
+                curves::draw_bezier_curve(vaos[0], visible_curves);
+            }
+            curve_pass_timer.end();
+
+            if (report_frame_times && glfwGetTime() - last_report_time > 2.0) {
+                double milliseconds = curve_pass_timer.takeAverageMilliseconds();
+                if (milliseconds >= 0.0) {
+                    const char* style = "line strips";
+                    if (active_line_style == line_style::batched_strip) {
+                        style = "batched line strips";
+                    } else if (active_line_style == line_style::wide) {
+                        style = "wide lines";
+                    }
+                    std::cout << "Curve pass: " << milliseconds << " ms GPU (" << style << ")" << std::endl;
+                }
+
+                double average, maximum;
+                if (input_latency.takeMilliseconds(average, maximum)) {
+                    std::cout << "Input to present: " << average << " ms average, " << maximum << " ms max" << std::endl;
+                }
+                if (cursor_latency.takeMilliseconds(average, maximum)) {
+                    std::cout << "Cursor sample to present: " << average << " ms average, " << maximum << " ms max ("
+                              << (late_latch_cursor ? "read before upload" : "read at frame start") << ")" << std::endl;
+                }
+                last_report_time = glfwGetTime();
+            }
+
+            shaderProgram.use();
+            glEnable(GL_PROGRAM_POINT_SIZE);
 
-        if (active_visibility == visibility::show) {
-            curves::draw_control_polygon(vaos[1], vbos[1]);
+            if (active_visibility == visibility::show) {
+                curves::draw_control_polygon(vaos[1], vbos[1], visible_curves);
+
+                if (!selected_vertices.empty()) {
+                    shaderProgram.setInt(highlight_mode_location, 1);
+                    curves::draw_selected_vertices(vaos[1], visible_curves, selected_vertices);
+                }
+            }
+
+            if (active_gesture != selection_gesture::none) {
+                shaderProgram.setInt(highlight_mode_location, 2);
+                curves::draw_selection_outline(vaos[1], vbos[1], gesture_outline(cursor_position_world));
+            }
+            shaderProgram.setInt(highlight_mode_location, 0);
+
+            // The HUD leaves itself out of what it shows
+            std::size_t upload_bytes = curves::take_uploaded_bytes();
+            if (show_stats) {
+                StatsHud::Sample sample{};
+                sample.curves = visible_curves.size();
+                for (int c : visible_curves) {
+                    sample.samples += curves::resident_samples(scene_curves[c]);
+                }
+                sample.upload_bytes = upload_bytes;
+                sample.cpu_milliseconds = (glfwGetTime() - tick_time) * 1e3;
+                sample.gpu_milliseconds = curve_pass_timer.lastMilliseconds();
+
+                stats_hud.record(sample);
+                stats_hud.draw();
+            }
+
+            glfwSwapBuffers(window);
+            input_latency.framePresented();
+            cursor_latency.framePresented();
+
+            autosave.flush();
+
+            // Every event wakes the wait, including cursor moves for hover
+            // highlighting
+            if (redraw_continuously(window)) {
+                glfwPollEvents();
+            } else {
+                glfwWaitEventsTimeout(idle_redraw_interval);
+            }
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (render_thread.running()) {
+            render_thread.stop();
+            glfwMakeContextCurrent(window);
+        }
+
+        curves::set_edit_observer(nullptr);
+        edit_log = nullptr;
+
+        glDeleteVertexArrays(3, vaos);
+        glDeleteBuffers(2, vbos);
+        glDeleteBuffers(1, &draw_id_vbo);
+        glDeleteBuffers(1, &frame_ubo);
+        glDeleteBuffers(1, &curve_ssbo);
     }
 
     glfwDestroyWindow(window);
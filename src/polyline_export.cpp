@@ -0,0 +1,187 @@
+#include "2dcurves/polyline_export.h"
+#include "2dcurves/AABB.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/scene_file.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        // Pieces shorter than 2^-max_depth of their parameter range are
+        // emitted as they are, which bounds the work for cusps
+        constexpr int max_depth = 24;
+
+        constexpr std::uint32_t binary_version = 1;
+
+        float distance_to_segment(glm::vec2 p, glm::vec2 a, glm::vec2 b)
+        {
+            glm::vec2 ab = b - a;
+            float length2 = glm::dot(ab, ab);
+            float s = length2 > 0.0f ? glm::clamp(glm::dot(p - a, ab) / length2, 0.0f, 1.0f) : 0.0f;
+            return glm::distance(p, a + s * ab);
+        }
+
+        bool is_flat(const glm::vec3* points, int degree, float tolerance)
+        {
+            glm::vec2 first = project(points[0]);
+            glm::vec2 last = project(points[degree]);
+            for (int i = 1; i < degree; ++i) {
+                if (distance_to_segment(project(points[i]), first, last) > tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void write_binary(std::ostream& out, const void* data, std::size_t size)
+        {
+            out.write(static_cast<const char*>(data), size);
+        }
+    }
+
+    void flatten_curve(const Curve& curve, const Vertex* vertices, float tolerance, std::vector<glm::vec2>& out)
+    {
+        assert(tolerance > 0.0f);
+
+        if (curve.num_vertices == 0) {
+            return;
+        }
+
+        std::vector<glm::vec3> pieces;
+        std::vector<float> breaks;
+        int degree = bezier_pieces(curve, vertices, pieces, breaks);
+        int stride = degree + 1;
+
+        out.push_back(project(pieces[0]));
+        if (degree == 0) {
+            return;
+        }
+
+        // Depth-first with the left half on top, so points come out in
+        // parameter order
+        std::vector<glm::vec3> stack;
+        std::vector<int> depths;
+
+        for (int k = 0; k + 1 < (int)breaks.size(); ++k) {
+            stack.assign(pieces.begin() + k * stride, pieces.begin() + (k + 1) * stride);
+            depths.assign(1, 0);
+
+            while (!depths.empty()) {
+                int depth = depths.back();
+                depths.pop_back();
+
+                std::size_t top = stack.size() - stride;
+                if (depth == max_depth || is_flat(stack.data() + top, degree, tolerance)) {
+                    out.push_back(project(stack.back()));
+                    stack.resize(top);
+                    continue;
+                }
+
+                // Split in place: the right half replaces the piece, the
+                // left half goes above it
+                stack.resize(top + 2 * stride);
+                glm::vec3* piece = stack.data() + top;
+                split_bezier(piece, degree, 0.5f, piece + stride, piece);
+                depths.push_back(depth + 1);
+                depths.push_back(depth + 1);
+            }
+        }
+    }
+
+    PolylineWriter::PolylineWriter(std::ostream& out, polyline_format format, const AABB& view)
+        : out(out), format(format)
+    {
+        out.precision(std::numeric_limits<float>::max_digits10);
+
+        if (format == polyline_format::binary) {
+            write_binary(out, "2DPL", 4);
+            write_binary(out, &binary_version, sizeof(binary_version));
+        } else if (format == polyline_format::svg) {
+            // SVG's y axis points down, so the view is mirrored and so is
+            // the group holding the curves
+            glm::vec2 size = view.size();
+            out << "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\""
+                << view.min.x << " " << -view.max.y << " " << size.x << " " << size.y << "\">\n"
+                << "<g transform=\"scale(1,-1)\" fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n";
+        } else {
+            out << "curve,point,x,y\n";
+        }
+    }
+
+    void PolylineWriter::write(int curve_index, const Curve& curve, const std::vector<glm::vec2>& points)
+    {
+        if (format == polyline_format::binary) {
+            std::uint32_t header[2] = {(std::uint32_t)curve_index, (std::uint32_t)points.size()};
+            write_binary(out, header, sizeof(header));
+            write_binary(out, points.data(), points.size() * sizeof(glm::vec2));
+        } else if (format == polyline_format::svg) {
+            // Widths are in pixels like on screen, whatever the view
+            glm::vec4 color = glm::clamp(curve.color, 0.0f, 1.0f);
+            out << "<polyline vector-effect=\"non-scaling-stroke\" stroke=\"rgb("
+                << (int)(color.r * 255.0f + 0.5f) << ","
+                << (int)(color.g * 255.0f + 0.5f) << ","
+                << (int)(color.b * 255.0f + 0.5f) << ")\" stroke-opacity=\"" << color.a
+                << "\" stroke-width=\"" << curve.width << "\" points=\"";
+            for (int i = 0; i < (int)points.size(); ++i) {
+                out << (i > 0 ? " " : "") << points[i].x << "," << points[i].y;
+            }
+            out << "\"/>\n";
+        } else {
+            for (int i = 0; i < (int)points.size(); ++i) {
+                out << curve_index << "," << i << "," << points[i].x << "," << points[i].y << "\n";
+            }
+        }
+
+        num_polylines++;
+        num_points += points.size();
+    }
+
+    void PolylineWriter::finish()
+    {
+        if (format == polyline_format::svg) {
+            out << "</g>\n</svg>\n";
+        }
+        out.flush();
+    }
+
+    int PolylineWriter::polylineCount() const
+    {
+        return num_polylines;
+    }
+
+    long long PolylineWriter::pointCount() const
+    {
+        return num_points;
+    }
+
+    bool export_polylines(std::istream& scene, float tolerance, PolylineWriter& writer)
+    {
+        SceneReader reader(scene);
+
+        // Reused for every curve, memory use is set by the largest one
+        Curve curve;
+        std::vector<Vertex> vertices;
+        std::vector<glm::vec2> points;
+
+        while (reader.next(curve, vertices)) {
+            points.clear();
+            flatten_curve(curve, vertices.data(), tolerance, points);
+            writer.write(reader.curveCount() - 1, curve, points);
+        }
+
+        return !reader.failed();
+    }
+}
@@ -0,0 +1,914 @@
+#include "2dcurves/scene.h"
+#include "2dcurves/AABB.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/closest_point.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/CurveBVH.h"
+#include "2dcurves/EditJournal.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/Vertex.h"
+#include "2dcurves/VertexSelection.h"
+
+#include <glm/mat3x3.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        CurveBVH curve_bvh;
+        bool curve_bvh_stale = true;
+
+        // Extra room around the view so that control points whose centers
+        // lie just outside the window are still drawn
+        constexpr float view_margin_NDC = 0.05f;
+
+        void update_bvh()
+        {
+            if (curve_bvh_stale) {
+                curve_bvh.build(scene_curves);
+                curve_bvh_stale = false;
+            }
+        }
+
+        void recompute_bounds(Curve& curve)
+        {
+            curve.bounds = AABB();
+            for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                curve.bounds.expand(control_vertices[i].position);
+            }
+        }
+
+        void mark_edited(Curve& curve)
+        {
+            curve.dirty = true;
+            curve.revision++;
+        }
+
+        // A scene set aside by a scene replacement. Undoing or redoing the
+        // replacement swaps it with the current one.
+        struct SceneStash
+        {
+            std::vector<Vertex> vertices;
+            std::vector<Curve> curves;
+        };
+
+        std::unordered_map<std::uint32_t, SceneStash> scene_stashes;
+        std::uint32_t next_stash = 0;
+
+        void discard_record(const EditRecord& record)
+        {
+            if (record.type == edit_type::swap_scene) {
+                SceneEdit edit;
+                std::memcpy(&edit, record.payload, sizeof(edit));
+                scene_stashes.erase(edit.stash);
+            }
+        }
+
+        constexpr std::size_t journal_arena_bytes = std::size_t(16) << 20;
+        constexpr std::size_t journal_stash_bytes = std::size_t(512) << 20;
+
+        EditJournal journal(journal_arena_bytes, journal_stash_bytes, discard_record);
+
+        // Nonzero while undoing, redoing or building a replacement scene,
+        // whose mutations are not recorded
+        int recording_paused = 0;
+
+        void (*edit_observer)(const EditRecord* record, bool forward) = nullptr;
+
+        void notify(edit_type type, const void* payload, std::size_t size)
+        {
+            if (edit_observer != nullptr) {
+                EditRecord record{type, static_cast<const unsigned char*>(payload), size};
+                edit_observer(&record, true);
+            }
+        }
+
+        void record_vertex_edit(edit_type type, int curve_index, int vertex_index, const Vertex& before, const Vertex& after)
+        {
+            if (recording_paused > 0) {
+                return;
+            }
+
+            VertexEdit edit{
+                curve_index, vertex_index, before.position, before.weight, after.position, after.weight
+            };
+            if (type == edit_type::move_vertex) {
+                journal.appendMove(edit);
+            } else {
+                journal.append(type, &edit, sizeof(edit));
+            }
+            notify(type, &edit, sizeof(edit));
+        }
+
+        // ListEdit header, then num_before and num_after values of
+        // value_floats floats each
+        void record_list_edit(
+            edit_type type,
+            int curve_index,
+            const float* before,
+            int num_before,
+            const float* after,
+            int num_after,
+            int value_floats
+        )
+        {
+            if (recording_paused > 0) {
+                return;
+            }
+
+            thread_local std::vector<unsigned char> payload;
+            ListEdit header{curve_index, num_before, num_after};
+            std::size_t before_bytes = num_before * value_floats * sizeof(float);
+            std::size_t after_bytes = num_after * value_floats * sizeof(float);
+
+            payload.resize(sizeof(header) + before_bytes + after_bytes);
+            std::memcpy(payload.data(), &header, sizeof(header));
+            if (before_bytes > 0) {
+                std::memcpy(payload.data() + sizeof(header), before, before_bytes);
+            }
+            if (after_bytes > 0) {
+                std::memcpy(payload.data() + sizeof(header) + before_bytes, after, after_bytes);
+            }
+
+            journal.append(type, payload.data(), payload.size());
+            notify(type, payload.data(), payload.size());
+        }
+
+        void record_knot_edit(int curve_index, const std::vector<float>& before, const std::vector<float>& after)
+        {
+            if (before != after) {
+                record_list_edit(
+                    edit_type::set_knots, curve_index, before.data(), before.size(), after.data(), after.size(), 1
+                );
+            }
+        }
+
+        // The before or after values of a ListEdit record
+        std::vector<float> list_values(const EditRecord& record, bool after, int value_floats)
+        {
+            ListEdit header;
+            std::memcpy(&header, record.payload, sizeof(header));
+
+            const unsigned char* begin = record.payload + sizeof(header);
+            if (after) {
+                begin += header.num_before * value_floats * sizeof(float);
+            }
+
+            std::vector<float> values((after ? header.num_after : header.num_before) * value_floats);
+            if (!values.empty()) {
+                std::memcpy(values.data(), begin, values.size() * sizeof(float));
+            }
+            return values;
+        }
+
+        // Keeps the knot vector of a NURBS curve consistent with its number
+        // of vertices after one was added or removed
+        void update_knots(Curve& curve, int old_num_vertices)
+        {
+            if (curve.knots.empty()) {
+                return;
+            }
+
+            int degree = curve.knots.size() - old_num_vertices - 1;
+            degree = std::min(degree, curve.num_vertices - 1);
+
+            if (degree < 1) {
+                curve.knots.clear();
+            } else {
+                curve.knots = clamped_uniform_knots(curve.num_vertices, degree);
+            }
+        }
+
+        void bounds_changed(int curve_index)
+        {
+            if (!curve_bvh_stale) {
+                curve_bvh.refit(scene_curves, curve_index);
+            }
+        }
+
+        // Replaces the vertices of the active curve, which are the last ones
+        // of control_vertices, by the homogeneous points
+        void replace_active_vertices(const glm::vec3* points, int num_points)
+        {
+            Curve& curve = scene_curves.back();
+
+            if (recording_paused == 0) {
+                thread_local std::vector<float> before, after;
+                before.clear();
+                after.clear();
+                for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                    const Vertex& v = control_vertices[i];
+                    before.insert(before.end(), {v.position.x, v.position.y, v.weight});
+                }
+                for (int i = 0; i < num_points; ++i) {
+                    glm::vec2 position = project(points[i]);
+                    after.insert(after.end(), {position.x, position.y, points[i].z});
+                }
+                record_list_edit(
+                    edit_type::replace_vertices,
+                    scene_curves.size() - 1,
+                    before.data(),
+                    curve.num_vertices,
+                    after.data(),
+                    num_points,
+                    3
+                );
+            }
+
+            control_vertices.resize(curve.first_vertex);
+            for (int i = 0; i < num_points; ++i) {
+                Vertex v(project(points[i]));
+                v.weight = points[i].z;
+                control_vertices.push_back(v);
+            }
+
+            curve.num_vertices = num_points;
+            mark_edited(curve);
+            recompute_bounds(curve);
+            bounds_changed(scene_curves.size() - 1);
+        }
+
+        // Homogeneous control points of the active curve if it is a Bézier
+        // curve of degree min_degree to max_degree, nullptr otherwise
+        const Curve* active_bezier(int min_degree, int max_degree, glm::vec3* points)
+        {
+            const Curve& curve = scene_curves.back();
+            int degree = curve.num_vertices - 1;
+            if (!curve.knots.empty() || degree < min_degree || degree > max_degree) {
+                return nullptr;
+            }
+
+            for (int i = 0; i <= degree; ++i) {
+                points[i] = lift(control_vertices[curve.first_vertex + i]);
+            }
+            return &curve;
+        }
+
+        // Appends an empty active curve with the appearance of new_curve
+        void push_curve(Curve new_curve)
+        {
+            new_curve.first_vertex = control_vertices.size();
+            scene_curves.push_back(std::move(new_curve));
+            curve_bvh_stale = true;
+
+            if (recording_paused == 0) {
+                const Curve& curve = scene_curves.back();
+                CurveEdit edit{curve.color, curve.width};
+                journal.append(edit_type::new_curve, &edit, sizeof(edit));
+                notify(edit_type::new_curve, &edit, sizeof(edit));
+            }
+        }
+
+        void swap_scene(std::uint32_t stash)
+        {
+            SceneStash& other = scene_stashes.at(stash);
+            std::swap(control_vertices, other.vertices);
+            std::swap(scene_curves, other.curves);
+            curve_bvh_stale = true;
+
+            // The cached samples are still valid but not on the GPU
+            for (Curve& curve : scene_curves) {
+                curve.flags &= ~curve_flag_hovered;
+                curve.needs_upload = true;
+                curve.upload_begin = 0;
+                curve.upload_end = curve.samples.size();
+            }
+        }
+
+        // Index of the non-empty curve holding vertex
+        int curve_of_vertex(int vertex)
+        {
+            // Empty curves share their first vertex with the next one, the
+            // last curve starting at or before vertex holds it
+            auto it = std::upper_bound(
+                scene_curves.begin(), scene_curves.end(), vertex,
+                [](int v, const Curve& curve) { return v < curve.first_vertex; }
+            );
+            return it - scene_curves.begin() - 1;
+        }
+
+        // Even-odd rule
+        bool inside_polygon(glm::vec2 point, const std::vector<glm::vec2>& polygon)
+        {
+            bool inside = false;
+            for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+                glm::vec2 a = polygon[i];
+                glm::vec2 b = polygon[j];
+                if ((a.y > point.y) != (b.y > point.y) &&
+                    point.x < a.x + (point.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        }
+
+        // Adds the vertices of the curves overlapping region that pass test
+        template <typename F>
+        void select_vertices(const AABB& region, VertexSelection& selection, F&& test)
+        {
+            update_bvh();
+            selection.resize(control_vertices.size());
+
+            thread_local std::vector<int> candidates;
+            candidates.clear();
+            curve_bvh.query(scene_curves, region, candidates);
+
+            for (int c : candidates) {
+                const Curve& curve = scene_curves[c];
+                for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                    glm::vec2 p = control_vertices[i].position;
+                    if (p.x >= region.min.x && p.x <= region.max.x &&
+                        p.y >= region.min.y && p.y <= region.max.y && test(p)) {
+                        selection.insert(i);
+                    }
+                }
+            }
+        }
+
+        // Applies a journal record forwards for redo, backwards for undo.
+        // Vertices and knots are set as recorded, without the knot updates
+        // of add_vertex and remove_last_vertex, which have their own record.
+        void apply_record(const EditRecord& record, bool forward)
+        {
+            switch (record.type) {
+            case edit_type::add_vertex:
+            case edit_type::remove_vertex: {
+                VertexEdit edit;
+                std::memcpy(&edit, record.payload, sizeof(edit));
+                Curve& curve = scene_curves[edit.curve];
+                assert(curve.first_vertex + curve.num_vertices == (int)control_vertices.size());
+
+                bool adding = (record.type == edit_type::add_vertex) == forward;
+                if (adding) {
+                    Vertex v(forward ? edit.after_position : edit.before_position);
+                    v.weight = forward ? edit.after_weight : edit.before_weight;
+                    control_vertices.push_back(v);
+                    curve.num_vertices++;
+                    curve.bounds.expand(v.position);
+                } else {
+                    control_vertices.pop_back();
+                    curve.num_vertices--;
+                    recompute_bounds(curve);
+                }
+                mark_edited(curve);
+                bounds_changed(edit.curve);
+                break;
+            }
+            case edit_type::move_vertex:
+            case edit_type::set_weight: {
+                VertexEdit edit;
+                std::memcpy(&edit, record.payload, sizeof(edit));
+                if (record.type == edit_type::move_vertex) {
+                    move_vertex(edit.curve, edit.vertex, forward ? edit.after_position : edit.before_position);
+                } else {
+                    set_vertex_weight(edit.curve, edit.vertex, forward ? edit.after_weight : edit.before_weight);
+                }
+                break;
+            }
+            case edit_type::set_knots: {
+                ListEdit header;
+                std::memcpy(&header, record.payload, sizeof(header));
+                scene_curves[header.curve].knots = list_values(record, forward, 1);
+                mark_edited(scene_curves[header.curve]);
+                break;
+            }
+            case edit_type::replace_vertices: {
+                // Set as stored, going through homogeneous points would round
+                std::vector<float> values = list_values(record, forward, 3);
+                Curve& curve = scene_curves.back();
+                control_vertices.resize(curve.first_vertex);
+                for (std::size_t i = 0; i < values.size(); i += 3) {
+                    Vertex v(glm::vec2(values[i], values[i + 1]));
+                    v.weight = values[i + 2];
+                    control_vertices.push_back(v);
+                }
+
+                curve.num_vertices = values.size() / 3;
+                mark_edited(curve);
+                recompute_bounds(curve);
+                bounds_changed(scene_curves.size() - 1);
+                break;
+            }
+            case edit_type::new_curve: {
+                if (forward) {
+                    CurveEdit edit;
+                    std::memcpy(&edit, record.payload, sizeof(edit));
+                    Curve new_curve;
+                    new_curve.color = edit.color;
+                    new_curve.width = edit.width;
+                    push_curve(std::move(new_curve));
+                } else {
+                    assert(scene_curves.size() > 1 && scene_curves.back().num_vertices == 0);
+                    scene_curves.pop_back();
+                    curve_bvh_stale = true;
+                }
+                break;
+            }
+            case edit_type::swap_scene: {
+                SceneEdit edit;
+                std::memcpy(&edit, record.payload, sizeof(edit));
+                swap_scene(edit.stash);
+                break;
+            }
+            }
+        }
+    }
+
+    void add_vertex(glm::vec2 position)
+    {
+        Curve& curve = scene_curves.back();
+        assert(curve.first_vertex + curve.num_vertices == (int)control_vertices.size());
+        int curve_index = scene_curves.size() - 1;
+
+        std::vector<float> old_knots;
+        if (recording_paused == 0) {
+            old_knots = curve.knots;
+        }
+
+        control_vertices.push_back(Vertex(position));
+        curve.num_vertices++;
+        mark_edited(curve);
+        update_knots(curve, curve.num_vertices - 1);
+
+        curve.bounds.expand(position);
+        bounds_changed(curve_index);
+
+        if (recording_paused == 0) {
+            const Vertex& added = control_vertices.back();
+            record_vertex_edit(edit_type::add_vertex, curve_index, control_vertices.size() - 1, added, added);
+            record_knot_edit(curve_index, old_knots, curve.knots);
+        }
+    }
+
+    void remove_last_vertex()
+    {
+        Curve& curve = scene_curves.back();
+        if (curve.num_vertices == 0) {
+            return;
+        }
+
+        int curve_index = scene_curves.size() - 1;
+        std::vector<float> old_knots;
+        if (recording_paused == 0) {
+            old_knots = curve.knots;
+            const Vertex& removed = control_vertices.back();
+            record_vertex_edit(edit_type::remove_vertex, curve_index, control_vertices.size() - 1, removed, removed);
+        }
+
+        glm::vec2 removed = control_vertices.back().position;
+        control_vertices.pop_back();
+        curve.num_vertices--;
+        mark_edited(curve);
+        update_knots(curve, curve.num_vertices + 1);
+
+        if (curve.bounds.on_boundary(removed)) {
+            recompute_bounds(curve);
+            bounds_changed(curve_index);
+        }
+
+        record_knot_edit(curve_index, old_knots, curve.knots);
+    }
+
+    void move_vertex(int curve_index, int vertex_index, glm::vec2 position)
+    {
+        Curve& curve = scene_curves[curve_index];
+        assert(vertex_index >= curve.first_vertex);
+        assert(vertex_index < curve.first_vertex + curve.num_vertices);
+
+        Vertex& v = control_vertices[vertex_index];
+        if (v.position == position) {
+            return;
+        }
+
+        Vertex old_vertex = v;
+        glm::vec2 old_position = v.position;
+        v.position = position;
+        record_vertex_edit(edit_type::move_vertex, curve_index, vertex_index, old_vertex, v);
+
+        // Dragging moves the cached samples in place when it can
+        if (apply_vertex_delta(curve, vertex_index - curve.first_vertex, position - old_position)) {
+            curve.revision++;
+        } else {
+            mark_edited(curve);
+        }
+
+        // Moving an interior vertex can only grow the box
+        if (curve.bounds.on_boundary(old_position)) {
+            recompute_bounds(curve);
+        } else {
+            curve.bounds.expand(position);
+        }
+        bounds_changed(curve_index);
+    }
+
+    void set_vertex_weight(int curve_index, int vertex_index, float weight)
+    {
+        // Positive weights keep the curve inside the control polygon bounds
+        assert(weight > 0.0f);
+
+        Vertex& v = control_vertices[vertex_index];
+        Vertex old_vertex = v;
+        v.weight = weight;
+        mark_edited(scene_curves[curve_index]);
+        record_vertex_edit(edit_type::set_weight, curve_index, vertex_index, old_vertex, v);
+    }
+
+    void set_curve_knots(int curve_index, std::vector<float> knots)
+    {
+        if (recording_paused == 0) {
+            record_knot_edit(curve_index, scene_curves[curve_index].knots, knots);
+        }
+
+        scene_curves[curve_index].knots = std::move(knots);
+        mark_edited(scene_curves[curve_index]);
+    }
+
+    void start_new_curve()
+    {
+        push_curve(Curve());
+    }
+
+    bool elevate_degree()
+    {
+        glm::vec3 points[max_bezier_degree + 1];
+        const Curve* curve = active_bezier(1, max_bezier_degree - 1, points);
+        if (curve == nullptr) {
+            return false;
+        }
+
+        glm::vec3 elevated[max_bezier_degree + 1];
+        elevate_bezier(points, curve->num_vertices - 1, elevated);
+        replace_active_vertices(elevated, curve->num_vertices + 1);
+        return true;
+    }
+
+    bool reduce_degree()
+    {
+        glm::vec3 points[max_bezier_degree + 1];
+        const Curve* curve = active_bezier(2, max_bezier_degree, points);
+        if (curve == nullptr) {
+            return false;
+        }
+
+        glm::vec3 reduced[max_bezier_degree + 1];
+        reduce_bezier(points, curve->num_vertices - 1, reduced);
+
+        // The fit can give non-positive weights for strongly rational
+        // curves, which the renderer cannot handle
+        for (int i = 0; i < curve->num_vertices - 1; ++i) {
+            if (!(reduced[i].z > 0.0f)) {
+                return false;
+            }
+        }
+
+        replace_active_vertices(reduced, curve->num_vertices - 1);
+        return true;
+    }
+
+    bool split_curve(float t)
+    {
+        glm::vec3 points[max_bezier_degree + 1];
+        const Curve* curve = active_bezier(1, max_bezier_degree, points);
+        if (curve == nullptr || !(t > 0.0f && t < 1.0f)) {
+            return false;
+        }
+
+        int num_points = curve->num_vertices;
+        glm::vec4 color = curve->color;
+        float width = curve->width;
+
+        glm::vec3 right[max_bezier_degree + 1];
+        split_bezier(points, num_points - 1, t, points, right);
+
+        begin_edit();
+        replace_active_vertices(points, num_points);
+
+        Curve second_half;
+        second_half.color = color;
+        second_half.width = width;
+        push_curve(std::move(second_half));
+        replace_active_vertices(right, num_points);
+        end_edit();
+        return true;
+    }
+
+    void clear_scene()
+    {
+        begin_scene_replacement();
+        end_scene_replacement();
+    }
+
+    void begin_scene_replacement()
+    {
+        // Setting the old scene aside is O(1), the journal only holds its id
+        std::uint32_t stash = next_stash++;
+        SceneStash& old_scene = scene_stashes[stash];
+        old_scene.vertices.swap(control_vertices);
+        old_scene.curves.swap(scene_curves);
+
+        control_vertices.clear();
+        scene_curves.assign(1, Curve());
+        curve_bvh_stale = true;
+
+        if (recording_paused == 0) {
+            std::size_t bytes = old_scene.vertices.capacity() * sizeof(Vertex)
+                + old_scene.curves.capacity() * sizeof(Curve);
+            SceneEdit edit{stash};
+            journal.append(edit_type::swap_scene, &edit, sizeof(edit), bytes);
+        } else {
+            scene_stashes.erase(stash);
+        }
+
+        recording_paused++;
+    }
+
+    void end_scene_replacement()
+    {
+        assert(recording_paused > 0);
+        recording_paused--;
+
+        if (recording_paused == 0 && edit_observer != nullptr) {
+            edit_observer(nullptr, true);
+        }
+    }
+
+    void begin_edit()
+    {
+        journal.beginStep();
+    }
+
+    void end_edit()
+    {
+        journal.endStep();
+    }
+
+    bool undo()
+    {
+        thread_local std::vector<EditRecord> records;
+        if (!journal.undo(records)) {
+            return false;
+        }
+
+        recording_paused++;
+        for (const EditRecord& record : records) {
+            apply_record(record, false);
+            if (edit_observer != nullptr) {
+                edit_observer(record.type == edit_type::swap_scene ? nullptr : &record, false);
+            }
+        }
+        recording_paused--;
+        return true;
+    }
+
+    bool redo()
+    {
+        thread_local std::vector<EditRecord> records;
+        if (!journal.redo(records)) {
+            return false;
+        }
+
+        recording_paused++;
+        for (const EditRecord& record : records) {
+            apply_record(record, true);
+            if (edit_observer != nullptr) {
+                edit_observer(record.type == edit_type::swap_scene ? nullptr : &record, true);
+            }
+        }
+        recording_paused--;
+        return true;
+    }
+
+    void clear_edit_history()
+    {
+        journal.clear();
+    }
+
+    void set_edit_observer(void (*observer)(const EditRecord* record, bool forward))
+    {
+        edit_observer = observer;
+    }
+
+    void transform_vertices(const VertexSelection& selection, const glm::mat3& transform)
+    {
+        glm::vec2 axis_x(transform[0][0], transform[0][1]);
+        glm::vec2 axis_y(transform[1][0], transform[1][1]);
+        glm::vec2 translation(transform[2][0], transform[2][1]);
+
+        int num_vertices = std::min(selection.size(), (int)control_vertices.size());
+        int curve_index = -1;
+
+        // Drags only translate. The samples then follow the vertices in
+        // place like in move_vertex, and a curve moved as a whole only
+        // moves its sample origin. Other transforms re-evaluate.
+        bool translation_only = axis_x == glm::vec2(1.0f, 0.0f) && axis_y == glm::vec2(0.0f, 1.0f);
+        bool samples_follow = translation_only;
+
+        // Runs are visited in order, so each curve is finished once all of
+        // its runs are moved
+        auto finish_curve = [&] {
+            if (curve_index >= 0) {
+                Curve& curve = scene_curves[curve_index];
+                if (samples_follow) {
+                    curve.revision++;
+                } else {
+                    mark_edited(curve);
+                }
+                recompute_bounds(curve);
+                bounds_changed(curve_index);
+            }
+            samples_follow = translation_only;
+        };
+
+        thread_local std::vector<Vertex> before;
+
+        begin_edit();
+        selection.forEachRun([&](int first, int count) {
+            int end = std::min(first + count, num_vertices);
+            while (first < end) {
+                if (curve_index < 0 ||
+                    first >= scene_curves[curve_index].first_vertex + scene_curves[curve_index].num_vertices) {
+                    finish_curve();
+                    curve_index = curve_of_vertex(first);
+                }
+
+                const Curve& curve = scene_curves[curve_index];
+                int run_end = std::min(end, curve.first_vertex + curve.num_vertices);
+                Vertex* vertices = control_vertices.data();
+
+                if (recording_paused == 0) {
+                    before.assign(vertices + first, vertices + run_end);
+                }
+
+                // The same multiply-adds for every vertex of the run, without
+                // branches or calls in between
+                for (int i = first; i < run_end; ++i) {
+                    glm::vec2 p = vertices[i].position;
+                    vertices[i].position = axis_x * p.x + axis_y * p.y + translation;
+                }
+
+                if (recording_paused == 0) {
+                    for (int i = first; i < run_end; ++i) {
+                        const Vertex& old_vertex = before[i - first];
+                        if (old_vertex.position != vertices[i].position) {
+                            record_vertex_edit(edit_type::move_vertex, curve_index, i, old_vertex, vertices[i]);
+                        }
+                    }
+                }
+
+                if (samples_follow) {
+                    Curve& moved = scene_curves[curve_index];
+                    if (first == moved.first_vertex && run_end == moved.first_vertex + moved.num_vertices) {
+                        // The samples are relative to the origin, so they
+                        // and the cached levels stay as they are
+                        moved.sample_origin += translation;
+                    } else {
+                        for (int i = first; i < run_end && samples_follow; ++i) {
+                            samples_follow = apply_vertex_delta(moved, i - moved.first_vertex, translation);
+                        }
+                    }
+                }
+
+                first = run_end;
+            }
+        });
+        finish_curve();
+        end_edit();
+    }
+
+    void apply_edit(const EditRecord& record, bool forward)
+    {
+        // Scene swaps refer to stashes that only live in this process
+        assert(record.type != edit_type::swap_scene);
+
+        recording_paused++;
+        apply_record(record, forward);
+        recording_paused--;
+    }
+
+    void generate_random_scene(int num_curves, int num_vertices, float width, unsigned int seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> channel(0.3f, 1.0f);
+
+        begin_scene_replacement();
+        control_vertices.reserve(num_curves * num_vertices);
+        scene_curves.reserve(num_curves);
+
+        for (int c = 0; c < num_curves; ++c) {
+            if (c > 0) {
+                start_new_curve();
+            }
+
+            Curve& curve = scene_curves.back();
+            curve.color = glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f);
+            curve.width = width;
+
+            for (int i = 0; i < num_vertices; ++i) {
+                add_vertex(glm::vec2(coordinate(generator), coordinate(generator)));
+            }
+        }
+
+        end_scene_replacement();
+    }
+
+    int pick_curve(glm::vec2 point, float radius)
+    {
+        update_bvh();
+
+        AABB pick_box;
+        pick_box.min = point - glm::vec2(radius);
+        pick_box.max = point + glm::vec2(radius);
+
+        thread_local std::vector<int> candidates;
+        candidates.clear();
+        curve_bvh.query(scene_curves, pick_box, candidates);
+
+        int res = -1;
+        float best_distance = radius;
+        for (int c : candidates) {
+            float distance = closest_point(scene_curves[c], point).distance;
+            if (distance <= best_distance) {
+                best_distance = distance;
+                res = c;
+            }
+        }
+
+        return res;
+    }
+
+    void select_vertices_in_box(const AABB& box, VertexSelection& selection)
+    {
+        select_vertices(box, selection, [](glm::vec2) { return true; });
+    }
+
+    void select_vertices_in_lasso(const std::vector<glm::vec2>& lasso, VertexSelection& selection)
+    {
+        if (lasso.size() < 3) {
+            return;
+        }
+
+        AABB region;
+        for (glm::vec2 point : lasso) {
+            region.expand(point);
+        }
+
+        select_vertices(region, selection, [&](glm::vec2 p) { return inside_polygon(p, lasso); });
+    }
+
+    AABB selection_bounds(const VertexSelection& selection)
+    {
+        int num_vertices = std::min(selection.size(), (int)control_vertices.size());
+
+        AABB res;
+        selection.forEachRun([&](int first, int count) {
+            for (int i = first; i < std::min(first + count, num_vertices); ++i) {
+                res.expand(control_vertices[i].position);
+            }
+        });
+        return res;
+    }
+
+    void flag_selected_curves(const VertexSelection& selection)
+    {
+        for (Curve& curve : scene_curves) {
+            curve.flags &= ~curve_flag_selected;
+        }
+
+        int num_vertices = std::min(selection.size(), (int)control_vertices.size());
+        selection.forEachRun([&](int first, int count) {
+            int end = std::min(first + count, num_vertices);
+            while (first < end) {
+                Curve& curve = scene_curves[curve_of_vertex(first)];
+                curve.flags |= curve_flag_selected;
+                first = curve.first_vertex + curve.num_vertices;
+            }
+        });
+    }
+
+    void visible_curves(const Camera& camera, std::vector<int>& out)
+    {
+        update_bvh();
+
+        glm::vec2 half_extent((1.0f + view_margin_NDC) / camera.zoom);
+
+        AABB view;
+        view.min = glm::vec2(camera.center) - half_extent;
+        view.max = glm::vec2(camera.center) + half_extent;
+
+        curve_bvh.query(scene_curves, view, out);
+    }
+}
@@ -0,0 +1,358 @@
+#include "2dcurves/scene_file.h"
+#include "2dcurves/bezier.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/scene.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        constexpr int file_version = 1;
+
+        constexpr char binary_magic[4] = {'2', 'D', 'C', 'B'};
+        constexpr std::uint32_t binary_version = 1;
+
+        template <typename T>
+        void write_value(std::ostream& out, const T& value)
+        {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool read_value(std::istream& in, T& value)
+        {
+            return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        // Why a curve read from a file cannot be used, nullptr if it can.
+        // The Bézier pieces of every curve must fit the arrays of the
+        // operations of bezier.h.
+        const char* invalid_curve(const Curve& curve)
+        {
+            if (curve.knots.empty()) {
+                if (curve.num_vertices > max_bezier_degree + 1) {
+                    return "too many vertices for a Bézier curve";
+                }
+                return nullptr;
+            }
+
+            bool finite = std::all_of(curve.knots.begin(), curve.knots.end(), [](float knot) {
+                return std::isfinite(knot);
+            });
+            int degree = finite ? nurbs_degree(curve) : 0;
+            if (degree == 0) {
+                return "knot vectors must be finite, clamped, match the vertex count and repeat interior knots at most degree times";
+            }
+            if (degree > max_bezier_degree) {
+                return "NURBS degree too high";
+            }
+            return nullptr;
+        }
+
+        bool binary_failure(const char* message, int num_curves)
+        {
+            std::cerr << "ERROR::SCENE_FILE::" << message << " (after " << num_curves << " curves)" << std::endl;
+            return false;
+        }
+
+        // Reads one curve of a binary file
+        bool read_binary_curve(std::istream& in, int curve_index, Curve& curve, std::vector<Vertex>& vertices)
+        {
+            std::uint32_t num_vertices = 0;
+            std::uint32_t num_knots = 0;
+            glm::vec4 color;
+            float width = 1.0f;
+            if (!read_value(in, num_vertices) || !read_value(in, num_knots)
+                || !read_value(in, color) || !read_value(in, width)) {
+                return binary_failure("malformed curve header", curve_index);
+            }
+
+            // Bounds the allocations a corrupt count could cause
+            if (num_vertices > (1u << 28) || num_knots > (1u << 28)) {
+                return binary_failure("invalid vertex or knot count", curve_index);
+            }
+            if (num_knots == 0 && num_vertices > max_bezier_degree + 1) {
+                return binary_failure("too many vertices for a Bézier curve", curve_index);
+            }
+
+            curve = Curve();
+            curve.color = color;
+            curve.width = width;
+            curve.num_vertices = num_vertices;
+
+            vertices.clear();
+            for (std::uint32_t i = 0; i < num_vertices; ++i) {
+                float vertex[3];
+                if (!read_value(in, vertex)) {
+                    return binary_failure("malformed vertex", curve_index);
+                }
+                if (!(vertex[2] > 0.0f) || !std::isfinite(vertex[0]) || !std::isfinite(vertex[1])) {
+                    return binary_failure("vertex weights must be positive and positions finite", curve_index);
+                }
+
+                vertices.push_back(Vertex{glm::vec2(vertex[0], vertex[1]), vertex[2]});
+            }
+
+            for (std::uint32_t i = 0; i < num_knots; ++i) {
+                float knot;
+                if (!read_value(in, knot)) {
+                    return binary_failure("malformed knot vector", curve_index);
+                }
+                curve.knots.push_back(knot);
+            }
+
+            if (const char* error = invalid_curve(curve)) {
+                return binary_failure(error, curve_index);
+            }
+            return true;
+        }
+
+        // Replaces the scene with curves read and validated beforehand
+        void replace_scene(std::vector<Curve>& curves, std::vector<std::vector<Vertex>>& curve_vertices)
+        {
+            begin_scene_replacement();
+
+            for (std::size_t c = 0; c < curves.size(); ++c) {
+                if (c > 0) {
+                    start_new_curve();
+                }
+
+                int curve_index = scene_curves.size() - 1;
+                scene_curves[curve_index].color = curves[c].color;
+                scene_curves[curve_index].width = curves[c].width;
+
+                for (const Vertex& v : curve_vertices[c]) {
+                    add_vertex(v.position);
+                    if (v.weight != 1.0f) {
+                        set_vertex_weight(curve_index, control_vertices.size() - 1, v.weight);
+                    }
+                }
+
+                if (!curves[c].knots.empty()) {
+                    set_curve_knots(curve_index, std::move(curves[c].knots));
+                }
+            }
+
+            end_scene_replacement();
+        }
+    }
+
+    void write_scene_header(std::ostream& out)
+    {
+        out << "2dcurves " << file_version << "\n";
+    }
+
+    void write_curve(std::ostream& out, const Curve& curve, const Vertex* vertices)
+    {
+        // Enough digits to read back the same floats
+        out.precision(std::numeric_limits<float>::max_digits10);
+
+        out << "curve " << curve.num_vertices << " " << curve.knots.size() << " "
+            << curve.color.r << " " << curve.color.g << " " << curve.color.b << " " << curve.color.a << " "
+            << curve.width << "\n";
+
+        for (int i = 0; i < curve.num_vertices; ++i) {
+            out << vertices[i].position.x << " " << vertices[i].position.y << " " << vertices[i].weight << "\n";
+        }
+
+        if (!curve.knots.empty()) {
+            for (int i = 0; i < (int)curve.knots.size(); ++i) {
+                out << (i > 0 ? " " : "") << curve.knots[i];
+            }
+            out << "\n";
+        }
+    }
+
+    void write_scene(std::ostream& out)
+    {
+        write_scene_header(out);
+        for (const Curve& curve : scene_curves) {
+            if (curve.num_vertices > 0) {
+                write_curve(out, curve, control_vertices.data() + curve.first_vertex);
+            }
+        }
+    }
+
+    SceneReader::SceneReader(std::istream& in) : in(in)
+    {
+        std::string magic;
+        int version = 0;
+        if (!(in >> magic >> version) || magic != "2dcurves") {
+            fail("not a 2dcurves scene file");
+        } else if (version != file_version) {
+            fail("unsupported scene file version");
+        }
+    }
+
+    bool SceneReader::next(Curve& curve, std::vector<Vertex>& vertices)
+    {
+        if (has_failed) {
+            return false;
+        }
+
+        std::string keyword;
+        if (!(in >> keyword)) {
+            // A clean end of the input is not a failure
+            if (!in.eof()) {
+                fail("read error");
+            }
+            return false;
+        }
+
+        if (keyword != "curve") {
+            return fail("expected 'curve'");
+        }
+
+        int num_vertices = 0;
+        int num_knots = 0;
+        glm::vec4 color;
+        float width = 1.0f;
+        if (!(in >> num_vertices >> num_knots >> color.r >> color.g >> color.b >> color.a >> width)) {
+            return fail("malformed curve header");
+        }
+        if (num_vertices < 1 || num_knots < 0) {
+            return fail("invalid vertex or knot count");
+        }
+
+        curve = Curve();
+        curve.num_vertices = num_vertices;
+        curve.color = color;
+        curve.width = width;
+
+        // Vertices and knots are appended as they are read, so a corrupt
+        // count runs into the end of the input instead of allocating it
+        vertices.clear();
+        for (int i = 0; i < num_vertices; ++i) {
+            Vertex v{glm::vec2(0.0f)};
+            if (!(in >> v.position.x >> v.position.y >> v.weight)) {
+                return fail("malformed vertex");
+            }
+            if (!(v.weight > 0.0f) || !std::isfinite(v.position.x) || !std::isfinite(v.position.y)) {
+                return fail("vertex weights must be positive and positions finite");
+            }
+            curve.bounds.expand(v.position);
+            vertices.push_back(v);
+        }
+
+        for (int i = 0; i < num_knots; ++i) {
+            float knot;
+            if (!(in >> knot)) {
+                return fail("malformed knot vector");
+            }
+            curve.knots.push_back(knot);
+        }
+        if (const char* error = invalid_curve(curve)) {
+            return fail(error);
+        }
+
+        num_curves++;
+        return true;
+    }
+
+    bool SceneReader::failed() const
+    {
+        return has_failed;
+    }
+
+    int SceneReader::curveCount() const
+    {
+        return num_curves;
+    }
+
+    bool SceneReader::fail(const char* message)
+    {
+        std::cerr << "ERROR::SCENE_FILE::" << message << " (after " << num_curves << " curves)" << std::endl;
+        has_failed = true;
+        return false;
+    }
+
+    bool load_scene(std::istream& in)
+    {
+        // The whole file is read before the scene is touched, so that a
+        // malformed one leaves it as it was
+        SceneReader reader(in);
+        std::vector<Curve> curves;
+        std::vector<std::vector<Vertex>> curve_vertices;
+
+        Curve curve;
+        std::vector<Vertex> vertices;
+        while (reader.next(curve, vertices)) {
+            curves.push_back(std::move(curve));
+            curve_vertices.push_back(std::move(vertices));
+        }
+        if (reader.failed()) {
+            return false;
+        }
+
+        replace_scene(curves, curve_vertices);
+        return true;
+    }
+
+    void write_scene_binary(std::ostream& out)
+    {
+        out.write(binary_magic, sizeof(binary_magic));
+        write_value(out, binary_version);
+        write_value(out, std::uint32_t(scene_curves.size()));
+
+        for (const Curve& curve : scene_curves) {
+            write_value(out, std::uint32_t(curve.num_vertices));
+            write_value(out, std::uint32_t(curve.knots.size()));
+            write_value(out, curve.color);
+            write_value(out, curve.width);
+
+            for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                const Vertex& v = control_vertices[i];
+                float vertex[3] = {v.position.x, v.position.y, v.weight};
+                write_value(out, vertex);
+            }
+
+            out.write(reinterpret_cast<const char*>(curve.knots.data()), curve.knots.size() * sizeof(float));
+        }
+    }
+
+    bool load_scene_binary(std::istream& in)
+    {
+        char magic[sizeof(binary_magic)];
+        std::uint32_t version = 0;
+        std::uint32_t num_curves = 0;
+        if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), binary_magic)) {
+            return binary_failure("not a binary 2dcurves scene file", 0);
+        }
+        if (!read_value(in, version) || version != binary_version) {
+            return binary_failure("unsupported scene file version", 0);
+        }
+        if (!read_value(in, num_curves) || num_curves == 0) {
+            return binary_failure("malformed curve count", 0);
+        }
+
+        // As for text files, every curve is read before the scene is touched
+        std::vector<Curve> curves;
+        std::vector<std::vector<Vertex>> curve_vertices;
+        for (std::uint32_t c = 0; c < num_curves; ++c) {
+            Curve curve;
+            std::vector<Vertex> vertices;
+            if (!read_binary_curve(in, c, curve, vertices)) {
+                return false;
+            }
+            curves.push_back(std::move(curve));
+            curve_vertices.push_back(std::move(vertices));
+        }
+
+        replace_scene(curves, curve_vertices);
+        return true;
+    }
+}
@@ -0,0 +1,100 @@
+#include "2dcurves/shader_data.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        // Number of ids currently stored in the draw id buffer
+        int draw_id_capacity = 0;
+
+        // Either thread may hold the context
+        std::atomic<std::size_t> uploaded_bytes{0};
+    }
+
+    void create_shader_data_buffers(unsigned int& frame_ubo, unsigned int& curve_ssbo)
+    {
+        glCreateBuffers(1, &frame_ubo);
+        glNamedBufferStorage(frame_ubo, sizeof(FrameData), NULL, GL_DYNAMIC_STORAGE_BIT);
+        glBindBufferBase(GL_UNIFORM_BUFFER, frame_block_binding, frame_ubo);
+
+        glCreateBuffers(1, &curve_ssbo);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curve_block_binding, curve_ssbo);
+    }
+
+    void count_uploaded_bytes(std::size_t bytes)
+    {
+        uploaded_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    std::size_t take_uploaded_bytes()
+    {
+        return uploaded_bytes.exchange(0, std::memory_order_relaxed);
+    }
+
+    void upload_frame_data(unsigned int frame_ubo, const FrameData& frame)
+    {
+        glNamedBufferSubData(frame_ubo, 0, sizeof(FrameData), &frame);
+        count_uploaded_bytes(sizeof(FrameData));
+    }
+
+    void make_curve_records(const Camera& camera, std::vector<CurveRecord>& records)
+    {
+        records.clear();
+        records.reserve(scene_curves.size());
+
+        for (const Curve& curve : scene_curves) {
+            glm::vec2 origin = camera_relative(camera, curve.sample_origin);
+            records.push_back(CurveRecord{curve.color, curve.width, curve.flags, origin});
+        }
+    }
+
+    void upload_curve_records(unsigned int curve_ssbo, unsigned int draw_id_vbo)
+    {
+        std::vector<CurveRecord> records;
+        make_curve_records(camera, records);
+        upload_curve_records(curve_ssbo, draw_id_vbo, records);
+    }
+
+    void upload_curve_records(unsigned int curve_ssbo, unsigned int draw_id_vbo, const std::vector<CurveRecord>& records)
+    {
+        // A storage block must not be bound to an empty buffer
+        CurveRecord empty{};
+        const CurveRecord* data = records.empty() ? &empty : records.data();
+        std::size_t num_records = std::max<std::size_t>(records.size(), 1);
+
+        // Re-specifying the whole store lets the driver orphan the old one
+        glNamedBufferData(
+            curve_ssbo,
+            num_records * sizeof(CurveRecord),
+            data,
+            GL_DYNAMIC_DRAW
+        );
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, curve_block_binding, curve_ssbo);
+        count_uploaded_bytes(num_records * sizeof(CurveRecord));
+
+        // Draw ids only change when the number of curves grows
+        if (draw_id_capacity < (int)num_records) {
+            draw_id_capacity = std::max(2 * draw_id_capacity, (int)num_records);
+
+            std::vector<unsigned int> draw_ids(draw_id_capacity);
+            std::iota(draw_ids.begin(), draw_ids.end(), 0u);
+
+            glNamedBufferData(
+                draw_id_vbo,
+                draw_ids.size() * sizeof(unsigned int),
+                draw_ids.data(),
+                GL_STATIC_DRAW
+            );
+            count_uploaded_bytes(draw_ids.size() * sizeof(unsigned int));
+        }
+    }
+}
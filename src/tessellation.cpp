@@ -0,0 +1,781 @@
+#include "2dcurves/tessellation.h"
+#include "2dcurves/arc_length.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/utils.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <list>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace curves{
+
+    namespace {
+        std::map<std::pair<int, int>, std::vector<float>> basis_tables;
+        std::map<std::pair<int, int>, std::vector<double>> basis_tables_double;
+
+        // Knot vectors change with every edit of a NURBS curve, so the
+        // B-spline tables are kept in least recently used order and the
+        // oldest are dropped past max_bspline_basis_tables
+        struct CachedBSplineBasisTable
+        {
+            int num_samples;
+            std::vector<float> knots;
+            BSplineBasisTable table;
+        };
+
+        constexpr std::size_t max_bspline_basis_tables = 64;
+        std::list<CachedBSplineBasisTable> bspline_basis_tables;
+
+        // Scratch buffer for the sums of weights of rational evaluation
+        thread_local std::vector<float> weight_sums;
+
+        // Curves in the sample buffer, in buffer order
+        std::vector<int> resident_curves;
+
+        // In-place sample updates before a curve is re-evaluated from
+        // scratch, which resets the rounding errors they accumulate
+        constexpr int max_incremental_updates = 256;
+
+        // Knot span containing u, algorithm A2.1 of The NURBS Book
+        template <typename T>
+        int find_span(int n, int degree, T u, const std::vector<float>& knots)
+        {
+            if (u >= knots[n + 1]) {
+                return n;
+            }
+            if (u <= knots[degree]) {
+                return degree;
+            }
+
+            int low = degree;
+            int high = n + 1;
+            int mid = (low + high) / 2;
+            while (u < knots[mid] || u >= knots[mid + 1]) {
+                if (u < knots[mid]) {
+                    high = mid;
+                } else {
+                    low = mid;
+                }
+                mid = (low + high) / 2;
+            }
+
+            return mid;
+        }
+
+        // Nonzero basis functions at u, algorithm A2.2 of The NURBS Book
+        template <typename T>
+        void basis_functions(int span, T u, int degree, const std::vector<float>& knots, T* out)
+        {
+            std::vector<T> left(degree + 1);
+            std::vector<T> right(degree + 1);
+
+            out[0] = T(1);
+            for (int j = 1; j <= degree; ++j) {
+                left[j] = u - knots[span + 1 - j];
+                right[j] = knots[span + j] - u;
+
+                T saved = T(0);
+                for (int r = 0; r < j; ++r) {
+                    T temp = out[r] / (right[r + 1] + left[j - r]);
+                    out[r] = saved + right[r + 1] * temp;
+                    saved = left[j - r] * temp;
+                }
+                out[j] = saved;
+            }
+        }
+
+        float screen_extent(const Curve& curve, const Camera& camera)
+        {
+            if (curve.bounds.empty()) {
+                return 0.0f;
+            }
+
+            glm::vec2 size = curve.bounds.size();
+            return std::max(size.x, size.y) * camera.zoom;
+        }
+
+        // Bernstein tables for the evaluation core in arithmetic T
+        template <typename T>
+        const std::vector<T>& bernstein_table(int degree, int num_samples);
+
+        template <>
+        const std::vector<float>& bernstein_table<float>(int degree, int num_samples)
+        {
+            return bernstein_basis_table(degree, num_samples);
+        }
+
+        template <>
+        const std::vector<double>& bernstein_table<double>(int degree, int num_samples)
+        {
+            auto [it, inserted] = basis_tables_double.try_emplace({degree, num_samples});
+            std::vector<double>& table = it->second;
+
+            if (inserted) {
+                table.resize(num_samples * (degree + 1));
+                for (int j = 0; j < num_samples; ++j) {
+                    double t = (double)j / (num_samples - 1);
+                    for (int i = 0; i <= degree; ++i) {
+                        table[i * num_samples + j] =
+                            binomial_coefficient(degree, i) * std::pow(t, i) * std::pow(1.0 - t, degree - i);
+                    }
+                }
+            }
+
+            return table;
+        }
+
+        // Error-free transformations: a + b = sum + error, a * b = product + error
+        void two_sum(double a, double b, double& sum, double& error)
+        {
+            sum = a + b;
+            double b_virtual = sum - a;
+            error = (a - (sum - b_virtual)) + (b - b_virtual);
+        }
+
+        void two_product(double a, double b, double& product, double& error)
+        {
+            product = a * b;
+            error = std::fma(a, b, -product);
+        }
+
+        // Compensated de Casteljau (Jiang et al., 2010) on n + 1 values,
+        // which it overwrites. Carries the rounding errors of every step
+        // in a second triangle and adds them back at the end.
+        double compensated_de_casteljau(double* values, double* errors, int n, double t)
+        {
+            double s, s_error;
+            two_sum(1.0, -t, s, s_error);
+
+            for (int i = 0; i <= n; ++i) {
+                errors[i] = 0.0;
+            }
+
+            for (int r = 1; r <= n; ++r) {
+                for (int i = 0; i <= n - r; ++i) {
+                    double left, left_error, right, right_error, sum, sum_error;
+                    two_product(s, values[i], left, left_error);
+                    two_product(t, values[i + 1], right, right_error);
+                    two_sum(left, right, sum, sum_error);
+
+                    double step_error = left_error + right_error + sum_error + s_error * values[i];
+                    errors[i] = s * errors[i] + t * errors[i + 1] + step_error;
+                    values[i] = sum;
+                }
+            }
+
+            return values[0] + errors[0];
+        }
+
+        // Makes level the one in curve.samples, -1 for none. The level in
+        // use goes to the cache unless the curve was edited since it was
+        // evaluated or holds in-place updates, and cached levels are swapped
+        // in without evaluation.
+        void select_lod_level(Curve& curve, int level)
+        {
+            if (curve.dirty) {
+                // Every level is evaluated again, relative to a new origin
+                curve.lod_cache_valid = 0;
+                if (curve.num_vertices > 0) {
+                    curve.sample_origin = control_vertices[curve.first_vertex].position;
+                }
+            } else if (curve.lod_level >= 0 && curve.incremental_updates == 0) {
+                std::swap(curve.samples, curve.lod_cache[curve.lod_level]);
+                curve.lod_cache_valid |= 1u << curve.lod_level;
+            }
+
+            curve.lod_level = level;
+            if (level < 0) {
+                curve.samples.clear();
+                return;
+            }
+
+            unsigned int bit = 1u << level;
+            if (curve.lod_cache_valid & bit) {
+                std::swap(curve.samples, curve.lod_cache[level]);
+                curve.lod_cache_valid &= ~bit;
+                return;
+            }
+
+            int samples = lod_level_samples(level);
+            curve.samples.resize(samples);
+            if (arc_length_sampling) {
+                // Goes through world coordinates, so precision is float
+                evaluate_curve_by_arc_length(curve, samples, curve.samples.data());
+                for (glm::vec2& sample : curve.samples) {
+                    sample = glm::vec2(glm::dvec2(sample) - glm::dvec2(curve.sample_origin));
+                }
+            } else {
+                evaluate_curve_samples(curve, curve.sample_origin, sample_precision, samples, curve.samples.data());
+            }
+        }
+    }
+
+    const std::vector<float>& bernstein_basis_table(int degree, int num_samples)
+    {
+        assert(degree >= 0 && num_samples > 1);
+
+        auto [it, inserted] = basis_tables.try_emplace({degree, num_samples});
+        std::vector<float>& table = it->second;
+
+        if (inserted) {
+            std::vector<float> t_values = linspace(0.0f, 1.0f, num_samples);
+            table.resize(num_samples * (degree + 1));
+
+            for (int i = 0; i <= degree; ++i) {
+                for (int j = 0; j < num_samples; ++j) {
+                    table[i * num_samples + j] = bernstein_polynomial(degree, i, t_values[j]);
+                }
+            }
+        }
+
+        return table;
+    }
+
+    const BSplineBasisTable& bspline_basis_table(const std::vector<float>& knots, int degree, int num_samples)
+    {
+        assert(degree >= 1 && num_samples > 1);
+
+        // Compared in place, the knots are only copied for a new table
+        auto it = std::find_if(
+            bspline_basis_tables.begin(),
+            bspline_basis_tables.end(),
+            [&](const CachedBSplineBasisTable& cached) {
+                return cached.table.degree == degree && cached.num_samples == num_samples && cached.knots == knots;
+            }
+        );
+        if (it != bspline_basis_tables.end()) {
+            bspline_basis_tables.splice(bspline_basis_tables.begin(), bspline_basis_tables, it);
+            return it->table;
+        }
+
+        if (bspline_basis_tables.size() >= max_bspline_basis_tables) {
+            bspline_basis_tables.pop_back();
+        }
+        bspline_basis_tables.push_front({num_samples, knots, BSplineBasisTable()});
+        BSplineBasisTable& table = bspline_basis_tables.front().table;
+
+        int n = knots.size() - degree - 2;
+        std::vector<float> u_values = linspace(knots[degree], knots[n + 1], num_samples);
+
+        table.degree = degree;
+        table.spans.resize(num_samples);
+        table.values.resize(num_samples * (degree + 1));
+
+        for (int j = 0; j < num_samples; ++j) {
+            int span = find_span(n, degree, u_values[j], knots);
+            table.spans[j] = span;
+            basis_functions(span, u_values[j], degree, knots, table.values.data() + j * (degree + 1));
+        }
+
+        return table;
+    }
+
+    std::vector<float> clamped_uniform_knots(int num_vertices, int degree)
+    {
+        assert(degree >= 1 && num_vertices > degree);
+
+        std::vector<float> res(num_vertices + degree + 1);
+        int num_interior = num_vertices - degree - 1;
+
+        for (int i = 0; i < (int)res.size(); ++i) {
+            int k = std::clamp(i - degree, 0, num_interior + 1);
+            res[i] = (float)k / (num_interior + 1);
+        }
+
+        return res;
+    }
+
+    int nurbs_degree(const Curve& curve)
+    {
+        if (curve.knots.empty()) {
+            return 0;
+        }
+
+        int degree = curve.knots.size() - curve.num_vertices - 1;
+        if (degree < 1 || degree >= curve.num_vertices) {
+            return 0;
+        }
+
+        if (!std::is_sorted(curve.knots.begin(), curve.knots.end())) {
+            return 0;
+        }
+
+        // Clamped ends, the curve interpolates its first and last vertex
+        const std::vector<float>& knots = curve.knots;
+        int last = knots.size() - 1;
+        if (knots[0] != knots[degree] || knots[last - degree] != knots[last]) {
+            return 0;
+        }
+
+        // Empty parameter domain
+        if (knots[degree] >= knots[curve.num_vertices]) {
+            return 0;
+        }
+
+        // Knots repeated beyond degree + 1 times at the ends or degree
+        // times inside break the curve apart, and the knot insertion of
+        // bezier_pieces assumes they are not
+        for (int i = 0; i <= last;) {
+            int end = i;
+            while (end < last && knots[end + 1] == knots[i]) {
+                end++;
+            }
+            int multiplicity = end - i + 1;
+            bool clamped_end = i == 0 || end == last;
+            if (multiplicity > (clamped_end ? degree + 1 : degree)) {
+                return 0;
+            }
+            i = end + 1;
+        }
+
+        return degree;
+    }
+
+    int lod_level(float screen_extent)
+    {
+        // num_samples is the density for a curve spanning one NDC unit
+        float target = num_samples * screen_extent;
+
+        int level = 0;
+        while (lod_level_samples(level) < target && level + 1 < num_lod_levels) {
+            level++;
+        }
+
+        return level;
+    }
+
+    int curve_lod_level(const Curve& curve, const Camera& camera)
+    {
+        if (curve.num_vertices == 0) {
+            return -1;
+        }
+        return lod_level(screen_extent(curve, camera));
+    }
+
+    void evaluate_bezier_curve(const Vertex* vertices, int num_vertices, int num_samples, glm::vec2* out)
+    {
+        assert(num_vertices > 0);
+
+        int degree = num_vertices - 1;
+        const std::vector<float>& basis = bernstein_basis_table(degree, num_samples);
+
+        // Accumulate one scaled basis column per vertex
+        std::fill(out, out + num_samples, glm::vec2(0.0f, 0.0f));
+        for (int i = 0; i <= degree; ++i) {
+            const float* column = basis.data() + i * num_samples;
+            glm::vec2 position = vertices[i].position;
+
+            for (int j = 0; j < num_samples; ++j) {
+                out[j] += column[j] * position;
+            }
+        }
+    }
+
+    void evaluate_rational_bezier_curve(const Vertex* vertices, int num_vertices, int num_samples, glm::vec2* out)
+    {
+        assert(num_vertices > 0);
+
+        int degree = num_vertices - 1;
+        const std::vector<float>& basis = bernstein_basis_table(degree, num_samples);
+
+        // Same accumulation as the polynomial case on (w x, w y) plus w
+        std::fill(out, out + num_samples, glm::vec2(0.0f, 0.0f));
+        weight_sums.assign(num_samples, 0.0f);
+
+        for (int i = 0; i <= degree; ++i) {
+            const float* column = basis.data() + i * num_samples;
+            float weight = vertices[i].weight;
+            glm::vec2 weighted_position = weight * vertices[i].position;
+
+            for (int j = 0; j < num_samples; ++j) {
+                out[j] += column[j] * weighted_position;
+                weight_sums[j] += column[j] * weight;
+            }
+        }
+
+        for (int j = 0; j < num_samples; ++j) {
+            out[j] /= weight_sums[j];
+        }
+    }
+
+    void evaluate_nurbs_curve(
+        const Vertex* vertices,
+        int num_vertices,
+        const std::vector<float>& knots,
+        int num_samples,
+        glm::vec2* out
+    )
+    {
+        int degree = knots.size() - num_vertices - 1;
+        const BSplineBasisTable& basis = bspline_basis_table(knots, degree, num_samples);
+
+        for (int j = 0; j < num_samples; ++j) {
+            const float* values = basis.values.data() + j * (degree + 1);
+            const Vertex* span_vertices = vertices + basis.spans[j] - degree;
+
+            glm::vec2 point(0.0f, 0.0f);
+            float weight_sum = 0.0f;
+            for (int k = 0; k <= degree; ++k) {
+                float b = values[k] * span_vertices[k].weight;
+                point += b * span_vertices[k].position;
+                weight_sum += b;
+            }
+            out[j] = point / weight_sum;
+        }
+    }
+
+    void evaluate_curve(const Curve& curve, int num_samples, glm::vec2* out)
+    {
+        const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+
+        if (nurbs_degree(curve) > 0) {
+            evaluate_nurbs_curve(vertices, curve.num_vertices, curve.knots, num_samples, out);
+            return;
+        }
+
+        bool rational = std::any_of(vertices, vertices + curve.num_vertices, [](const Vertex& v) {
+            return v.weight != 1.0f;
+        });
+
+        if (rational) {
+            evaluate_rational_bezier_curve(vertices, curve.num_vertices, num_samples, out);
+        } else {
+            evaluate_bezier_curve(vertices, curve.num_vertices, num_samples, out);
+        }
+    }
+
+    template <typename T>
+    void evaluate_curve_relative(const Curve& curve, glm::vec2 origin, int num_samples, glm::vec2* out)
+    {
+        assert(curve.num_vertices > 0 && num_samples > 1);
+
+        const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+        int num_vertices = curve.num_vertices;
+
+        // Homogeneous control points (w (p - origin), w), the difference is
+        // exact in double
+        thread_local std::vector<T> xs, ys, ws;
+        xs.resize(num_vertices);
+        ys.resize(num_vertices);
+        ws.resize(num_vertices);
+        bool rational = false;
+        for (int i = 0; i < num_vertices; ++i) {
+            T weight = vertices[i].weight;
+            xs[i] = weight * T((double)vertices[i].position.x - (double)origin.x);
+            ys[i] = weight * T((double)vertices[i].position.y - (double)origin.y);
+            ws[i] = weight;
+            rational |= vertices[i].weight != 1.0f;
+        }
+
+        int degree = nurbs_degree(curve);
+        if constexpr (std::is_same_v<T, float>) {
+            // The cached float basis table serves the float evaluation
+            if (degree > 0) {
+                const BSplineBasisTable& basis = bspline_basis_table(curve.knots, degree, num_samples);
+                for (int j = 0; j < num_samples; ++j) {
+                    const float* values = basis.values.data() + j * (degree + 1);
+                    int first = basis.spans[j] - degree;
+
+                    float x = 0.0f, y = 0.0f, w = 0.0f;
+                    for (int k = 0; k <= degree; ++k) {
+                        x += values[k] * xs[first + k];
+                        y += values[k] * ys[first + k];
+                        w += values[k] * ws[first + k];
+                    }
+                    out[j] = glm::vec2(x / w, y / w);
+                }
+                return;
+            }
+        }
+
+        if (degree > 0) {
+            const std::vector<float>& knots = curve.knots;
+            int n = num_vertices - 1;
+            T u_first = knots[degree];
+            T u_last = knots[n + 1];
+
+            thread_local std::vector<T> basis;
+            basis.resize(degree + 1);
+
+            for (int j = 0; j < num_samples; ++j) {
+                T u = j == num_samples - 1 ? u_last : u_first + (u_last - u_first) * T(j) / T(num_samples - 1);
+                int span = find_span(n, degree, u, knots);
+                basis_functions(span, u, degree, knots, basis.data());
+
+                T x = T(0), y = T(0), w = T(0);
+                for (int k = 0; k <= degree; ++k) {
+                    int i = span - degree + k;
+                    x += basis[k] * xs[i];
+                    y += basis[k] * ys[i];
+                    w += basis[k] * ws[i];
+                }
+                out[j] = glm::vec2(float(x / w), float(y / w));
+            }
+            return;
+        }
+
+        // One scaled basis column per vertex, as in evaluate_bezier_curve
+        const std::vector<T>& table = bernstein_table<T>(num_vertices - 1, num_samples);
+
+        if constexpr (std::is_same_v<T, float>) {
+            // Accumulating straight into out vectorizes as in evaluate_bezier_curve
+            if (!rational) {
+                std::fill(out, out + num_samples, glm::vec2(0.0f, 0.0f));
+                for (int i = 0; i < num_vertices; ++i) {
+                    const float* column = table.data() + i * num_samples;
+                    glm::vec2 position(xs[i], ys[i]);
+                    for (int j = 0; j < num_samples; ++j) {
+                        out[j] += column[j] * position;
+                    }
+                }
+                return;
+            }
+        }
+
+        thread_local std::vector<T> sums_x, sums_y, sums_w;
+        sums_x.assign(num_samples, T(0));
+        sums_y.assign(num_samples, T(0));
+        sums_w.assign(rational ? num_samples : 0, T(0));
+
+        for (int i = 0; i < num_vertices; ++i) {
+            const T* column = table.data() + i * num_samples;
+            for (int j = 0; j < num_samples; ++j) {
+                sums_x[j] += column[j] * xs[i];
+                sums_y[j] += column[j] * ys[i];
+            }
+            if (rational) {
+                for (int j = 0; j < num_samples; ++j) {
+                    sums_w[j] += column[j] * ws[i];
+                }
+            }
+        }
+
+        for (int j = 0; j < num_samples; ++j) {
+            T inverse_weight = rational ? T(1) / sums_w[j] : T(1);
+            out[j] = glm::vec2(float(sums_x[j] * inverse_weight), float(sums_y[j] * inverse_weight));
+        }
+    }
+
+    template void evaluate_curve_relative<float>(const Curve&, glm::vec2, int, glm::vec2*);
+    template void evaluate_curve_relative<double>(const Curve&, glm::vec2, int, glm::vec2*);
+
+    void evaluate_curve_compensated(const Curve& curve, glm::vec2 origin, int num_samples, glm::vec2* out)
+    {
+        assert(curve.num_vertices > 0 && num_samples > 1);
+
+        if (nurbs_degree(curve) > 0) {
+            evaluate_curve_relative<double>(curve, origin, num_samples, out);
+            return;
+        }
+
+        const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+        int n = curve.num_vertices - 1;
+
+        // Pristine control points per coordinate, plus a working copy that
+        // de Casteljau overwrites
+        thread_local std::vector<double> points, work, errors;
+        points.resize(3 * (n + 1));
+        work.resize(n + 1);
+        errors.resize(n + 1);
+        for (int i = 0; i <= n; ++i) {
+            double weight = vertices[i].weight;
+            points[i] = weight * ((double)vertices[i].position.x - (double)origin.x);
+            points[(n + 1) + i] = weight * ((double)vertices[i].position.y - (double)origin.y);
+            points[2 * (n + 1) + i] = weight;
+        }
+
+        for (int j = 0; j < num_samples; ++j) {
+            double t = (double)j / (num_samples - 1);
+
+            double coordinates[3];
+            for (int c = 0; c < 3; ++c) {
+                std::copy(points.begin() + c * (n + 1), points.begin() + (c + 1) * (n + 1), work.begin());
+                coordinates[c] = compensated_de_casteljau(work.data(), errors.data(), n, t);
+            }
+
+            out[j] = glm::vec2(float(coordinates[0] / coordinates[2]), float(coordinates[1] / coordinates[2]));
+        }
+    }
+
+    void evaluate_curve_samples(
+        const Curve& curve,
+        glm::vec2 origin,
+        evaluation_precision precision,
+        int num_samples,
+        glm::vec2* out
+    )
+    {
+        if (precision == evaluation_precision::compensated) {
+            evaluate_curve_compensated(curve, origin, num_samples, out);
+        } else if (precision == evaluation_precision::float64) {
+            evaluate_curve_relative<double>(curve, origin, num_samples, out);
+        } else {
+            evaluate_curve_relative<float>(curve, origin, num_samples, out);
+        }
+    }
+
+    bool apply_vertex_delta(Curve& curve, int vertex, glm::vec2 delta)
+    {
+        if (curve.dirty || curve.samples.empty() || arc_length_sampling) {
+            return false;
+        }
+        if (curve.incremental_updates >= max_incremental_updates) {
+            return false;
+        }
+
+        const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+        int num_samples = curve.samples.size();
+        glm::vec2* samples = curve.samples.data();
+        int first = 0;
+        int last = num_samples;
+
+        int degree = nurbs_degree(curve);
+        if (degree > 0) {
+            // Only the samples whose span involves the vertex move. Spans
+            // increase with the parameter, so they form one range.
+            const BSplineBasisTable& basis = bspline_basis_table(curve.knots, degree, num_samples);
+            first = std::lower_bound(basis.spans.begin(), basis.spans.end(), vertex) - basis.spans.begin();
+            last = std::upper_bound(basis.spans.begin(), basis.spans.end(), vertex + degree) - basis.spans.begin();
+
+            for (int j = first; j < last; ++j) {
+                const float* values = basis.values.data() + j * (degree + 1);
+                const Vertex* span_vertices = vertices + basis.spans[j] - degree;
+
+                float weight_sum = 0.0f;
+                for (int k = 0; k <= degree; ++k) {
+                    weight_sum += values[k] * span_vertices[k].weight;
+                }
+
+                float b = values[vertex - (basis.spans[j] - degree)] * vertices[vertex].weight;
+                samples[j] += (b / weight_sum) * delta;
+            }
+        } else {
+            // The denominator of a rational curve would have to be
+            // recomputed for every sample
+            bool rational = std::any_of(vertices, vertices + curve.num_vertices, [](const Vertex& v) {
+                return v.weight != 1.0f;
+            });
+            if (rational) {
+                return false;
+            }
+
+            const std::vector<float>& basis = bernstein_basis_table(curve.num_vertices - 1, num_samples);
+            const float* column = basis.data() + vertex * num_samples;
+            for (int j = 0; j < num_samples; ++j) {
+                samples[j] += column[j] * delta;
+            }
+        }
+
+        // Other levels no longer match the curve
+        curve.lod_cache_valid = 0;
+
+        if (first < last) {
+            if (curve.needs_upload) {
+                curve.upload_begin = std::min(curve.upload_begin, first);
+                curve.upload_end = std::max(curve.upload_end, last);
+            } else {
+                curve.upload_begin = first;
+                curve.upload_end = last;
+            }
+            curve.needs_upload = true;
+        }
+
+        curve.incremental_updates++;
+        return true;
+    }
+
+    glm::vec2 evaluate_curve_point(const Curve& curve, float t)
+    {
+        assert(curve.num_vertices > 0);
+
+        const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+        int degree = nurbs_degree(curve);
+
+        if (degree > 0) {
+            const std::vector<float>& knots = curve.knots;
+            int n = curve.num_vertices - 1;
+            float u = knots[degree] + t * (knots[n + 1] - knots[degree]);
+
+            int span = find_span(n, degree, u, knots);
+            std::vector<float> basis(degree + 1);
+            basis_functions(span, u, degree, knots, basis.data());
+
+            glm::vec2 point(0.0f, 0.0f);
+            float weight_sum = 0.0f;
+            for (int k = 0; k <= degree; ++k) {
+                const Vertex& v = vertices[span - degree + k];
+                point += basis[k] * v.weight * v.position;
+                weight_sum += basis[k] * v.weight;
+            }
+
+            return point / weight_sum;
+        }
+
+        // de Casteljau in homogeneous coordinates
+        thread_local std::vector<glm::vec3> points;
+        points.resize(curve.num_vertices);
+        for (int i = 0; i < curve.num_vertices; ++i) {
+            points[i] = glm::vec3(vertices[i].weight * vertices[i].position, vertices[i].weight);
+        }
+
+        for (int r = 1; r < curve.num_vertices; ++r) {
+            for (int i = 0; i < curve.num_vertices - r; ++i) {
+                points[i] = (1.0f - t) * points[i] + t * points[i + 1];
+            }
+        }
+
+        return glm::vec2(points[0].x, points[0].y) / points[0].z;
+    }
+
+    bool update_tessellations(const Camera& camera, const std::vector<int>& visible_curves)
+    {
+        bool layout_changed = visible_curves != resident_curves;
+        int offset = 0;
+
+        for (int c : visible_curves) {
+            Curve& curve = scene_curves[c];
+            int level = curve_lod_level(curve, camera);
+
+            if (curve.dirty || level != curve.lod_level) {
+                int old_samples = curve.samples.size();
+                select_lod_level(curve, level);
+
+                int samples = curve.samples.size();
+                layout_changed |= samples != old_samples;
+
+                curve.dirty = false;
+                curve.needs_upload = true;
+                curve.upload_begin = 0;
+                curve.upload_end = samples;
+                curve.incremental_updates = 0;
+            }
+
+            layout_changed |= curve.sample_offset != offset;
+            curve.sample_offset = offset;
+            offset += curve.samples.size();
+        }
+
+        if (layout_changed) {
+            resident_curves = visible_curves;
+        }
+
+        return layout_changed;
+    }
+
+    void invalidate_tessellation_layout()
+    {
+        resident_curves.clear();
+    }
+}
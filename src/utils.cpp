@@ -1,14 +1,19 @@
+#include "2dcurves/bezier.h"
+#include "2dcurves/Camera.h"
+#include "2dcurves/Curve.h"
 #include "2dcurves/global_vars.h"
+#include "2dcurves/shader_data.h"
+#include "2dcurves/tessellation.h"
 #include "2dcurves/Vertex.h"
+#include "2dcurves/VertexSelection.h"
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
 
-#include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <iterator>
+#include <numeric>
 #include <vector>
 
 namespace curves{
@@ -28,6 +33,11 @@ namespace curves{
         return glm::vec2(xposNDC, yposNDC);
     }
 
+    glm::vec2 get_cursor_position_world(GLFWwindow* window, const Camera& camera)
+    {
+        return ndc_to_world(camera, get_cursor_position_NDC(window));
+    }
+
     std::vector<float> linspace(float a, float b, int n)
     {
         assert(n > 1);
@@ -46,16 +56,19 @@ namespace curves{
     long long binomial_coefficient(int n, int k)
     {
         assert((k >= 0) && (n >= 0) && (n >= k));
-        assert(n <= 50);
+        assert(n <= max_bezier_degree);
 
         if (k > n - k) {
             k = n - k;
         }
 
+        // C(n, i + 1) = C(n, i) (n - i) / (i + 1), with the common factor of
+        // C(n, i) and i + 1 divided out first so that the product cannot
+        // overflow before the division, which it would past n = 61
         long long res = 1;
         for (int i = 0; i < k; ++i) {
-            res *= n - i;
-            res /= i + 1;
+            long long common = std::gcd(res, (long long)(i + 1));
+            res = res / common * ((n - i) / ((i + 1) / common));
         }
 
         return res;
@@ -68,47 +81,95 @@ namespace curves{
         return binomial_coefficient(n, i) * std::pow(t, i) * std::pow(1 - t, n - i);
     }
 
-    void draw_bezier_curve(unsigned int vao, unsigned int vbo)
+    void upload_bezier_curves(unsigned int vbo, const std::vector<int>& visible_curves)
     {
-        // Compute bezier points
-        std::vector<glm::vec2> bezier_points;
-        int bezier_degree = control_vertices.size() - 1;
-
-        for (float t_value : t_samples) {
-            glm::vec2 bezier_point(0.0, 0.0);
-            for (int i = 0; i <= bezier_degree; i++) {
-                bezier_point += bernstein_polynomial(bezier_degree, i, t_value) * control_vertices[i].position;
+        // Re-evaluate visible curves that were edited or whose LOD changed
+        bool layout_changed = update_tessellations(camera, visible_curves);
+
+        // Pass bezier points to OpenGL
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        if (layout_changed) {
+            std::vector<glm::vec2> bezier_points;
+            for (int c : visible_curves) {
+                Curve& curve = scene_curves[c];
+                bezier_points.insert(bezier_points.end(), curve.samples.begin(), curve.samples.end());
+                curve.needs_upload = false;
+            }
+
+            glBufferData(
+                GL_ARRAY_BUFFER,
+                bezier_points.size() * sizeof(glm::vec2),
+                bezier_points.data(),
+                GL_DYNAMIC_DRAW
+            );
+            count_uploaded_bytes(bezier_points.size() * sizeof(glm::vec2));
+        } else {
+            for (int c : visible_curves) {
+                Curve& curve = scene_curves[c];
+                if (!curve.needs_upload) {
+                    continue;
+                }
+
+                // Only the range touched since the last upload, which is
+                // part of the curve after a single vertex moved
+                glBufferSubData(
+                    GL_ARRAY_BUFFER,
+                    (curve.sample_offset + curve.upload_begin) * sizeof(glm::vec2),
+                    (curve.upload_end - curve.upload_begin) * sizeof(glm::vec2),
+                    curve.samples.data() + curve.upload_begin
+                );
+                count_uploaded_bytes((curve.upload_end - curve.upload_begin) * sizeof(glm::vec2));
+                curve.needs_upload = false;
             }
-            bezier_points.push_back(bezier_point);
         }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-        assert(bezier_points.size() == num_samples);
+    void draw_bezier_curve(unsigned int vao, const std::vector<int>& visible_curves)
+    {
+        // Draw, the base instance selects the curve record in the shader
+        glBindVertexArray(vao);
+        for (int c : visible_curves) {
+            const Curve& curve = scene_curves[c];
+            int num_samples = resident_samples(curve);
+            if (num_samples == 0) {
+                continue;
+            }
+            glDrawArraysInstancedBaseInstance(GL_LINE_STRIP, curve.sample_offset, num_samples, 1, c);
+        }
+        glBindVertexArray(0);
+    }
 
-        // Pass bezier_points to OpenGL
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(
-            GL_ARRAY_BUFFER,
-            bezier_points.size() * sizeof(glm::vec2),
-            bezier_points.data(),
-            GL_STATIC_DRAW
-        );
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    void draw_wide_bezier_curve(unsigned int vao, unsigned int vbo, const std::vector<int>& visible_curves)
+    {
+        // The vertex shader reads the samples directly from the curve buffer
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sample_block_binding, vbo);
 
-        // Draw
+        // Each segment is expanded to a quad of two triangles
         glBindVertexArray(vao);
-        glDrawArrays(GL_LINE_STRIP, 0, bezier_points.size());
+        for (int c : visible_curves) {
+            const Curve& curve = scene_curves[c];
+            int num_samples = resident_samples(curve);
+            if (num_samples < 2) {
+                continue;
+            }
+
+            int num_segments = num_samples - 1;
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 6 * curve.sample_offset, 6 * num_segments, 1, c);
+        }
         glBindVertexArray(0);
     }
 
-    void draw_control_polygon(unsigned int vao, unsigned int vbo)
+    void draw_control_polygon(unsigned int vao, unsigned int vbo, const std::vector<int>& visible_curves)
     {
-        std::vector<glm::vec2> control_vertices_positions;
-        std::transform(
-            control_vertices.begin(),
-            control_vertices.end(),
-            std::back_inserter(control_vertices_positions),
-            [](Vertex v) { return v.position; }
-        );
+        // Relative to the sample origin of their curve, like the samples
+        std::vector<glm::vec2> control_vertices_positions(control_vertices.size());
+        for (const Curve& curve : scene_curves) {
+            glm::dvec2 origin(curve.sample_origin);
+            for (int i = curve.first_vertex; i < curve.first_vertex + curve.num_vertices; ++i) {
+                control_vertices_positions[i] = glm::vec2(glm::dvec2(control_vertices[i].position) - origin);
+            }
+        }
 
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(
@@ -117,11 +178,57 @@ namespace curves{
             control_vertices_positions.data(),
             GL_STATIC_DRAW
         );
+        count_uploaded_bytes(control_vertices_positions.size() * sizeof(glm::vec2));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindVertexArray(vao);
+        for (int c : visible_curves) {
+            const Curve& curve = scene_curves[c];
+            glDrawArraysInstancedBaseInstance(GL_POINTS, curve.first_vertex, curve.num_vertices, 1, c);
+            glDrawArraysInstancedBaseInstance(GL_LINE_STRIP, curve.first_vertex, curve.num_vertices, 1, c);
+        }
+        glBindVertexArray(0);
+    }
+
+    void draw_selected_vertices(unsigned int vao, const std::vector<int>& visible_curves, const VertexSelection& selection)
+    {
+        glBindVertexArray(vao);
+        for (int c : visible_curves) {
+            const Curve& curve = scene_curves[c];
+            int end = curve.first_vertex + curve.num_vertices;
+
+            // One draw per run of selected vertices
+            int i = curve.first_vertex;
+            while (i < end) {
+                if (!selection.contains(i)) {
+                    i++;
+                    continue;
+                }
+
+                int first = i;
+                while (i < end && selection.contains(i)) {
+                    i++;
+                }
+                glDrawArraysInstancedBaseInstance(GL_POINTS, first, i - first, 1, c);
+            }
+        }
+        glBindVertexArray(0);
+    }
+
+    void draw_selection_outline(unsigned int vao, unsigned int vbo, const std::vector<glm::vec2>& outline)
+    {
+        std::vector<glm::vec2> positions(outline.size());
+        for (std::size_t i = 0; i < outline.size(); ++i) {
+            positions[i] = camera_relative(camera, outline[i]);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2), positions.data(), GL_STREAM_DRAW);
+        count_uploaded_bytes(positions.size() * sizeof(glm::vec2));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         glBindVertexArray(vao);
-        glDrawArrays(GL_POINTS, 0, control_vertices_positions.size());
-        glDrawArrays(GL_LINE_STRIP, 0, control_vertices_positions.size());
+        glDrawArrays(GL_LINE_LOOP, 0, positions.size());
         glBindVertexArray(0);
     }
-}
\ No newline at end of file
+}
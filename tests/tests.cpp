@@ -0,0 +1,382 @@
+// Property tests of the curve kernels. Configure with
+// -DTWODCURVES_BUILD_TESTS=ON and run ctest or 2dcurves_tests, optionally
+// with a substring of the test names to run. Exits with an error if any
+// check fails.
+
+#include "2dcurves/bezier.h"
+#include "2dcurves/chebyshev.h"
+#include "2dcurves/global_vars.h"
+#include "2dcurves/scene.h"
+#include "2dcurves/scene_file.h"
+#include "2dcurves/tessellation.h"
+#include "2dcurves/utils.h"
+#include "2dcurves/Vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    int num_failures = 0;
+
+    void check(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition) {
+            num_failures++;
+            std::cout << "  FAILED " << file << ":" << line << ": " << expression << std::endl;
+        }
+    }
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+    constexpr int num_samples = 257;
+
+    // A random curve with degree + 1 vertices in [-1, 1]^2 as the only one
+    // of the scene, with random weights if rational
+    const Curve& random_curve(int degree, bool rational, unsigned int seed)
+    {
+        curves::generate_random_scene(1, degree + 1, 1.0f, seed);
+
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> weight(0.25f, 4.0f);
+        if (rational) {
+            for (int i = 0; i <= degree; ++i) {
+                curves::set_vertex_weight(0, scene_curves[0].first_vertex + i, weight(generator));
+            }
+        }
+
+        return scene_curves[0];
+    }
+
+    // Whether point is inside the convex hull of points, up to tolerance.
+    // The hull is built with Andrew's monotone chain.
+    bool in_convex_hull(std::vector<glm::dvec2> points, glm::dvec2 point, double tolerance)
+    {
+        std::sort(points.begin(), points.end(), [](glm::dvec2 a, glm::dvec2 b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+
+        auto cross = [](glm::dvec2 o, glm::dvec2 a, glm::dvec2 b) {
+            return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+        };
+
+        int n = points.size();
+        std::vector<glm::dvec2> hull(2 * n);
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+                k--;
+            }
+            hull[k++] = points[i];
+        }
+        for (int i = n - 2, lower = k + 1; i >= 0; --i) {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+                k--;
+            }
+            hull[k++] = points[i];
+        }
+        hull.resize(std::max(k - 1, 1));
+
+        // Degenerate hulls are a point or a segment
+        if (hull.size() < 3) {
+            glm::dvec2 a = hull.front();
+            glm::dvec2 b = hull.back();
+            glm::dvec2 ab = b - a;
+            double length2 = glm::dot(ab, ab);
+            double t = length2 > 0.0 ? std::clamp(glm::dot(point - a, ab) / length2, 0.0, 1.0) : 0.0;
+            return glm::length(a + t * ab - point) <= tolerance;
+        }
+
+        // Counter-clockwise, so the point is left of every edge
+        for (std::size_t i = 0; i < hull.size(); ++i) {
+            glm::dvec2 a = hull[i];
+            glm::dvec2 b = hull[(i + 1) % hull.size()];
+            if (cross(a, b, point) < -tolerance * glm::length(b - a)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void test_binomials()
+    {
+        // Pascal's triangle only adds, so it is exact in 64 bits
+        std::vector<unsigned long long> row(1, 1);
+        for (int n = 0; n <= curves::max_bezier_degree; ++n) {
+            for (int k = 0; k <= n; ++k) {
+                CHECK((unsigned long long)curves::binomial_coefficient(n, k) == row[k]);
+            }
+
+            row.push_back(1);
+            for (int k = n; k >= 1; --k) {
+                row[k] += row[k - 1];
+            }
+        }
+    }
+
+    void test_partition_of_unity()
+    {
+        for (int degree = 0; degree <= curves::max_bezier_degree; ++degree) {
+            for (int j = 0; j < num_samples; ++j) {
+                float t = (float)j / (num_samples - 1);
+                double sum = 0.0;
+                bool nonnegative = true;
+                for (int i = 0; i <= degree; ++i) {
+                    float b = curves::bernstein_polynomial(degree, i, t);
+                    nonnegative = nonnegative && b >= 0.0f;
+                    sum += b;
+                }
+                CHECK(nonnegative);
+                CHECK(std::abs(sum - 1.0) < 1e-5);
+            }
+
+            const std::vector<float>& table = curves::bernstein_basis_table(degree, num_samples);
+            for (int j = 0; j < num_samples; ++j) {
+                double sum = 0.0;
+                for (int i = 0; i <= degree; ++i) {
+                    sum += table[i * num_samples + j];
+                }
+                CHECK(std::abs(sum - 1.0) < 1e-5);
+            }
+        }
+    }
+
+    void test_endpoint_interpolation()
+    {
+        for (int degree = 0; degree <= curves::max_bezier_degree; ++degree) {
+            for (int i = 0; i <= degree; ++i) {
+                CHECK(curves::bernstein_polynomial(degree, i, 0.0f) == (i == 0 ? 1.0f : 0.0f));
+                CHECK(curves::bernstein_polynomial(degree, i, 1.0f) == (i == degree ? 1.0f : 0.0f));
+            }
+        }
+
+        for (int degree = 1; degree <= curves::max_bezier_degree; ++degree) {
+            for (bool rational : {false, true}) {
+                const Curve& curve = random_curve(degree, rational, degree * 2 + rational);
+                const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+
+                std::vector<glm::vec2> samples(num_samples);
+                curves::evaluate_curve(curve, num_samples, samples.data());
+                CHECK(glm::length(samples.front() - vertices[0].position) < 1e-5f);
+                CHECK(glm::length(samples.back() - vertices[degree].position) < 1e-5f);
+            }
+        }
+
+        // Clamped knot vectors interpolate the end vertices as well
+        for (int degree = 1; degree <= 5; ++degree) {
+            for (int num_vertices = degree + 1; num_vertices <= degree + 8; ++num_vertices) {
+                curves::generate_random_scene(1, num_vertices, 1.0f, num_vertices * 13 + degree);
+                curves::set_curve_knots(0, curves::clamped_uniform_knots(num_vertices, degree));
+                const Curve& curve = scene_curves[0];
+                const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+
+                std::vector<glm::vec2> samples(num_samples);
+                curves::evaluate_curve(curve, num_samples, samples.data());
+                CHECK(glm::length(samples.front() - vertices[0].position) < 1e-5f);
+                CHECK(glm::length(samples.back() - vertices[num_vertices - 1].position) < 1e-5f);
+            }
+        }
+    }
+
+    void test_convex_hull()
+    {
+        for (int degree = 1; degree <= curves::max_bezier_degree; ++degree) {
+            for (bool rational : {false, true}) {
+                const Curve& curve = random_curve(degree, rational, degree * 3 + rational);
+                const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+
+                std::vector<glm::dvec2> points;
+                for (int i = 0; i <= degree; ++i) {
+                    points.push_back(glm::dvec2(vertices[i].position));
+                }
+
+                std::vector<glm::vec2> samples(num_samples);
+                curves::evaluate_curve(curve, num_samples, samples.data());
+                bool inside = std::all_of(samples.begin(), samples.end(), [&](glm::vec2 sample) {
+                    return in_convex_hull(points, glm::dvec2(sample), 1e-5);
+                });
+                CHECK(inside);
+            }
+        }
+    }
+
+    // The compensated evaluator is the reference the others are compared to
+    void test_evaluator_agreement()
+    {
+        for (int degree = 1; degree <= curves::max_bezier_degree; ++degree) {
+            for (bool rational : {false, true}) {
+                const Curve& curve = random_curve(degree, rational, degree * 5 + rational);
+                const Vertex* vertices = control_vertices.data() + curve.first_vertex;
+                glm::vec2 origin = vertices[0].position;
+
+                std::vector<glm::vec2> reference(num_samples);
+                std::vector<glm::vec2> single(num_samples);
+                std::vector<glm::vec2> relative(num_samples);
+                curves::evaluate_curve_compensated(curve, origin, num_samples, reference.data());
+                curves::evaluate_curve_relative<float>(curve, origin, num_samples, single.data());
+                curves::evaluate_curve_relative<double>(curve, origin, num_samples, relative.data());
+
+                float single_error = 0.0f;
+                float double_error = 0.0f;
+                for (int j = 0; j < num_samples; ++j) {
+                    single_error = std::max(single_error, glm::length(single[j] - reference[j]));
+                    double_error = std::max(double_error, glm::length(relative[j] - reference[j]));
+                }
+                CHECK(single_error < 1e-4f);
+                CHECK(double_error < 1e-6f);
+
+                // de Casteljau, the end of the left piece of a split
+                std::vector<glm::vec3> points(degree + 1);
+                std::vector<glm::vec3> left(degree + 1);
+                std::vector<glm::vec3> right(degree + 1);
+                for (int i = 0; i <= degree; ++i) {
+                    points[i] = curves::lift(vertices[i]);
+                }
+
+                float de_casteljau_error = 0.0f;
+                for (int j = 0; j < num_samples; ++j) {
+                    float t = (float)j / (num_samples - 1);
+                    curves::split_bezier(points.data(), degree, t, left.data(), right.data());
+                    glm::vec2 point = curves::project(left[degree]) - origin;
+                    de_casteljau_error = std::max(de_casteljau_error, glm::length(point - reference[j]));
+                }
+                CHECK(de_casteljau_error < 1e-4f);
+
+                if (rational) {
+                    continue;
+                }
+
+                std::vector<glm::dvec2> relative_points(degree + 1);
+                std::vector<glm::dvec2> coefficients(degree + 1);
+                for (int i = 0; i <= degree; ++i) {
+                    relative_points[i] = glm::dvec2(vertices[i].position) - glm::dvec2(origin);
+                }
+                curves::bernstein_to_chebyshev(relative_points.data(), degree, coefficients.data());
+
+                std::vector<glm::vec2> chebyshev(num_samples);
+                curves::evaluate_chebyshev_curve(coefficients.data(), degree, num_samples, chebyshev.data());
+
+                float chebyshev_error = 0.0f;
+                for (int j = 0; j < num_samples; ++j) {
+                    chebyshev_error = std::max(chebyshev_error, glm::length(chebyshev[j] - reference[j]));
+                }
+                CHECK(chebyshev_error < 1e-6f);
+            }
+        }
+    }
+
+    // Binary scene file holding one curve with the given vertices and knots
+    std::string binary_scene_file(const std::vector<glm::vec2>& positions, const std::vector<float>& knots)
+    {
+        std::string file = "2DCB";
+        auto append = [&](const auto& value) {
+            file.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+
+        append(std::uint32_t(1));
+        append(std::uint32_t(1));
+        append(std::uint32_t(positions.size()));
+        append(std::uint32_t(knots.size()));
+        for (float value : {1.0f, 1.0f, 1.0f, 1.0f, 1.0f}) {
+            append(value);
+        }
+        for (glm::vec2 position : positions) {
+            for (float value : {position.x, position.y, 1.0f}) {
+                append(value);
+            }
+        }
+        for (float knot : knots) {
+            append(knot);
+        }
+        return file;
+    }
+
+    // An interior knot of multiplicity degree + 1 splits the curve in two
+    // and made the knot insertion of bezier_pieces write out of bounds
+    void test_knot_multiplicity()
+    {
+        std::vector<glm::vec2> positions = {
+            glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(2.0f, 0.0f),
+            glm::vec2(3.0f, 1.0f), glm::vec2(4.0f, 0.0f), glm::vec2(5.0f, 0.0f)
+        };
+        std::vector<float> repeated = {0.0f, 0.0f, 0.0f, 0.5f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f};
+        std::vector<float> doubled = {0.0f, 0.0f, 0.0f, 0.25f, 0.5f, 0.5f, 1.0f, 1.0f, 1.0f};
+
+        auto text_scene_file = [&](const std::vector<float>& knots) {
+            std::ostringstream out;
+            out << "2dcurves 1\ncurve " << positions.size() << " " << knots.size() << " 1 1 1 1 1\n";
+            for (glm::vec2 position : positions) {
+                out << position.x << " " << position.y << " 1\n";
+            }
+            for (float knot : knots) {
+                out << knot << " ";
+            }
+            out << "\n";
+            return out.str();
+        };
+
+        Curve curve;
+        curve.num_vertices = positions.size();
+        curve.knots = repeated;
+        CHECK(curves::nurbs_degree(curve) == 0);
+        curve.knots = doubled;
+        CHECK(curves::nurbs_degree(curve) == 2);
+
+        std::istringstream repeated_text(text_scene_file(repeated));
+        CHECK(!curves::load_scene(repeated_text));
+        std::istringstream repeated_binary(binary_scene_file(positions, repeated));
+        CHECK(!curves::load_scene_binary(repeated_binary));
+
+        // Multiplicity degree only makes the curve continuous without a
+        // tangent there
+        std::istringstream doubled_text(text_scene_file(doubled));
+        CHECK(curves::load_scene(doubled_text));
+        std::istringstream doubled_binary(binary_scene_file(positions, doubled));
+        CHECK(curves::load_scene_binary(doubled_binary));
+    }
+
+    struct Test
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Test tests[] = {
+        {"binomials", test_binomials},
+        {"convex hull", test_convex_hull},
+        {"endpoint interpolation", test_endpoint_interpolation},
+        {"evaluator agreement", test_evaluator_agreement},
+        {"knot multiplicity", test_knot_multiplicity},
+        {"partition of unity", test_partition_of_unity},
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    for (const Test& test : tests) {
+        if (std::strstr(test.name, filter) == nullptr) {
+            continue;
+        }
+
+        std::cout << "[" << test.name << "]" << std::endl;
+        int failures_before = num_failures;
+        test.run();
+        std::cout << "  " << (num_failures == failures_before ? "passed" : "FAILED") << std::endl;
+    }
+
+    std::cout << num_failures << " failed checks" << std::endl;
+    return num_failures == 0 ? 0 : 1;
+}
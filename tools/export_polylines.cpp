@@ -0,0 +1,135 @@
+// Flattens the curves of a scene file into polylines for plotters and CAM
+// tools. Reads and writes one curve at a time, so scenes larger than memory
+// can be piped through it.
+//
+// 2dcurves_export [--tolerance t] [--format binary|svg|csv]
+//                 [--view min_x min_y max_x max_y] <scene | -> <output | ->
+
+#include "2dcurves/AABB.h"
+#include "2dcurves/polyline_export.h"
+
+#include <glm/vec2.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+    int usage()
+    {
+        std::cerr << "usage: 2dcurves_export [--tolerance t] [--format binary|svg|csv]\n"
+                  << "                       [--view min_x min_y max_x max_y] <scene | -> <output | ->\n"
+                  << "  --tolerance  maximum distance between curves and polylines (default 0.001)\n"
+                  << "  --format     output format (default csv)\n"
+                  << "  --view       region shown by SVG output (default -1 -1 1 1)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool parse_float(const char* text, float& value)
+    {
+        char* end = nullptr;
+        value = std::strtof(text, &end);
+        return end != text && *end == '\0';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    float tolerance = 1e-3f;
+    curves::polyline_format format = curves::polyline_format::csv;
+    AABB view;
+    view.expand(glm::vec2(-1.0f));
+    view.expand(glm::vec2(1.0f));
+
+    const char* input_path = nullptr;
+    const char* output_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            if (!parse_float(argv[++i], tolerance) || !(tolerance > 0.0f)) {
+                return usage();
+            }
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "binary") {
+                format = curves::polyline_format::binary;
+            } else if (name == "svg") {
+                format = curves::polyline_format::svg;
+            } else if (name == "csv") {
+                format = curves::polyline_format::csv;
+            } else {
+                return usage();
+            }
+        } else if (std::strcmp(argv[i], "--view") == 0 && i + 4 < argc) {
+            glm::vec2 corners[2];
+            if (!parse_float(argv[i + 1], corners[0].x) || !parse_float(argv[i + 2], corners[0].y) ||
+                !parse_float(argv[i + 3], corners[1].x) || !parse_float(argv[i + 4], corners[1].y)) {
+                return usage();
+            }
+            view = AABB();
+            view.expand(corners[0]);
+            view.expand(corners[1]);
+            i += 4;
+        } else if (input_path == nullptr) {
+            input_path = argv[i];
+        } else if (output_path == nullptr) {
+            output_path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+
+    if (input_path == nullptr || output_path == nullptr) {
+        return usage();
+    }
+
+    std::ifstream input_file;
+    std::istream* input = &std::cin;
+    if (std::strcmp(input_path, "-") != 0) {
+        input_file.open(input_path);
+        if (!input_file) {
+            std::cerr << "ERROR::EXPORT::CANNOT_OPEN " << input_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        input = &input_file;
+    }
+
+    std::ofstream output_file;
+    std::ostream* output = &std::cout;
+    if (std::strcmp(output_path, "-") != 0) {
+        output_file.open(output_path, std::ios::binary);
+        if (!output_file) {
+            std::cerr << "ERROR::EXPORT::CANNOT_OPEN " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        output = &output_file;
+    } else {
+#ifdef _WIN32
+        // Keep the CRT from turning \n into \r\n in binary output
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        std::ios::sync_with_stdio(false);
+    }
+
+    curves::PolylineWriter writer(*output, format, view);
+    bool ok = curves::export_polylines(*input, tolerance, writer);
+    writer.finish();
+
+    std::cerr << writer.polylineCount() << " polylines, " << writer.pointCount() << " points" << std::endl;
+
+    if (!*output) {
+        std::cerr << "ERROR::EXPORT::WRITE_FAILED" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}